@@ -1,44 +1,34 @@
 #include <iostream>
+#include "../../common/time_base.hpp"
 using namespace std;
 
-class Time {
+template <class Policy>
+class BasicTime : private TimeLifetime<Policy> {
     public:
         int hours, minutes, seconds;
-        static int count; 
 
-        Time(int h, int m, int s) : hours(h), minutes(m), seconds(s) {
+        BasicTime(int h, int m, int s) : hours(h), minutes(m), seconds(s) {
             Normalize();
-            count++; 
-            cout << "Constructor is called. Current count: " << count << endl;
-        }
-
-        ~Time() {
-            count--;
-            cout << "Destructor is called. Current count: " << count << endl;
         }
 
+        // Минуты и секунды сводятся в одно число и раскладываются делением
+        // с округлением вниз - то же, что прежние переносы по знаку; часы
+        // прибавляются отдельно, чтобы сумма не переполнялась ни при каких int.
+        // Отрицательные часы сохраняются, больше 23 - берутся по модулю 24.
         void Normalize() {
-            if (seconds < 0) {
-                int sec_from_min = (-seconds + 59) / 60;
-                minutes -= sec_from_min;
-                seconds += sec_from_min * 60;
-            } else if (seconds > 59) {
-                minutes += seconds / 60;
-                seconds %= 60;
-            }
-
-            if (minutes < 0) {
-                int min_from_hour = (-minutes + 59) / 60;
-                hours -= min_from_hour;
-                minutes += min_from_hour * 60;
-            } else if (minutes > 59) {
-                hours += minutes / 60;
-                minutes %= 60;
-            }
+            long long rest = minutes * 60LL + seconds;
+            long long total_minutes = FloorDiv<60>(rest);
+            long long carry = FloorDiv<3600>(rest);
+            seconds = static_cast<int>(rest - total_minutes * 60);
+            minutes = static_cast<int>(total_minutes - carry * 60);
+            long long h = hours + carry;
+            long long wrapped = h - FloorDiv<24>(h) * 24;
+            hours = static_cast<int>(h > 23 ? wrapped : h);
+        }
 
-            if (hours > 23) {
-                hours %= 24;
-            }
+        // То же, что BasicTime(0, 0, total).
+        static BasicTime FromSeconds(int total) {
+            return BasicTime(0, 0, total);
         }
 
         int ToSeconds() const {
@@ -49,31 +39,32 @@ class Time {
             cout << hours << ":" << minutes << ":" << seconds << endl;
         }
 
-        Time operator-(const Time& other) const {
-            int totalSec1 = ToSeconds();
-            int totalSec2 = other.ToSeconds();
-            int diff = totalSec1 - totalSec2;
-
-            int newHours = (diff / 3600) % 24;
-            diff %= 3600;
-            int newMinutes = diff / 60;
-            int newSeconds = diff % 60;
-
-            return Time(newHours, newMinutes, newSeconds);
+        // Часы разности, как и раньше, берутся по модулю 24 с усечением к нулю
+        // (для отрицательной разности они не больше нуля), минуты и секунды -
+        // с округлением вниз.
+        BasicTime operator-(const BasicTime& other) const {
+            int diff = ToSeconds() - other.ToSeconds();
+            long long total_minutes = FloorDiv<60>(diff);
+            long long total_hours = FloorDiv<3600>(diff);
+            long long days = FloorDiv<86400>(diff);
+            days += (diff < 0) & (diff != days * 86400);
+            return BasicTime(static_cast<int>(total_hours - days * 24),
+                static_cast<int>(total_minutes - total_hours * 60),
+                static_cast<int>(diff - total_minutes * 60));
         }
 
-        Time& operator-=(const Time& other) {
+        BasicTime& operator-=(const BasicTime& other) {
             *this = *this - other;
             return *this;
         }
 
-        bool operator==(const Time& other) const {
+        bool operator==(const BasicTime& other) const {
             return hours == other.hours && minutes == other.minutes && seconds == other.seconds;
         }
 
         static int GetCount() {
-            return count;
+            return TimeLifetime<Policy>::Count();
         }
 };
 
-int Time::count = 0;
\ No newline at end of file
+using Time = BasicTime<TIME_LIFETIME_POLICY>;
\ No newline at end of file
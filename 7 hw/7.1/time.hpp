@@ -1,52 +1,54 @@
 #include <iostream>
 #include <stdexcept>
+#include "../../common/time_base.hpp"
 using namespace std;
 
 class SimpleWatch;
 class Watch;
 
-class Time {
+template <class Policy>
+class BasicTime : private TimeLifetime<Policy> {
     private:
         int hours, minutes, seconds;
-        static int count; 
 
-    public:
-        Time(int h, int m, int s) : hours(h), minutes(m), seconds(s) {
+        struct Fields {
+            int h, m, s;
+        };
+
+        // Проверка выполняется до конструирования базы, поэтому при исключении
+        // счётчик и вывод не затрагиваются.
+        static Fields Checked(int h, int m, int s) {
             if (h < 0 || m < 0 || s < 0) {
                 throw invalid_argument("Negative values are not allowed for hours, minutes, or seconds.");
             }
-            Normalize();
-            count++; 
-            cout << "Constructor is called. Current count: " << count << endl;
+            return Fields{h, m, s};
         }
 
-        ~Time() noexcept {
-            count--;
-            cout << "Destructor is called. Current count: " << count << endl;
+        explicit BasicTime(Fields f) noexcept : hours(f.h), minutes(f.m), seconds(f.s) {
+            Normalize();
         }
 
-        void Normalize() noexcept {
-            if (seconds < 0) {
-                int sec_from_min = (-seconds + 59) / 60;
-                minutes -= sec_from_min;
-                seconds += sec_from_min * 60;
-            } else if (seconds > 59) {
-                minutes += seconds / 60;
-                seconds %= 60;
-            }
+    public:
+        BasicTime(int h, int m, int s) : BasicTime(Checked(h, m, s)) {}
 
-            if (minutes < 0) {
-                int min_from_hour = (-minutes + 59) / 60;
-                hours -= min_from_hour;
-                minutes += min_from_hour * 60;
-            } else if (minutes > 59) {
-                hours += minutes / 60;
-                minutes %= 60;
-            }
+        // Минуты и секунды сводятся в одно число и раскладываются делением
+        // с округлением вниз - то же, что прежние переносы по знаку; часы
+        // прибавляются отдельно, чтобы сумма не переполнялась ни при каких int.
+        // Отрицательные часы сохраняются, больше 23 - берутся по модулю 24.
+        void Normalize() noexcept {
+            long long rest = minutes * 60LL + seconds;
+            long long total_minutes = FloorDiv<60>(rest);
+            long long carry = FloorDiv<3600>(rest);
+            seconds = static_cast<int>(rest - total_minutes * 60);
+            minutes = static_cast<int>(total_minutes - carry * 60);
+            long long h = hours + carry;
+            long long wrapped = h - FloorDiv<24>(h) * 24;
+            hours = static_cast<int>(h > 23 ? wrapped : h);
+        }
 
-            if (hours > 23) {
-                hours %= 24;
-            }
+        // То же, что BasicTime(0, 0, total).
+        static BasicTime FromSeconds(int total) {
+            return BasicTime(0, 0, total);
         }
 
         int ToSeconds() const noexcept {
@@ -57,37 +59,38 @@ class Time {
             cout << hours << ":" << minutes << ":" << seconds << endl;
         }
 
-        Time operator-(const Time& other) const noexcept {
-            int totalSec1 = ToSeconds();
-            int totalSec2 = other.ToSeconds();
-            int diff = totalSec1 - totalSec2;
-
-            int newHours = (diff / 3600) % 24;
-            diff %= 3600;
-            int newMinutes = diff / 60;
-            int newSeconds = diff % 60;
-
-            return Time(newHours, newMinutes, newSeconds);
+        // Часы разности, как и раньше, берутся по модулю 24 с усечением к нулю,
+        // минуты и секунды - с округлением вниз. Результат, как и раньше, проходит
+        // проверку конструктора: отрицательная разность даёт исключение.
+        BasicTime operator-(const BasicTime& other) const noexcept {
+            int diff = ToSeconds() - other.ToSeconds();
+            long long total_minutes = FloorDiv<60>(diff);
+            long long total_hours = FloorDiv<3600>(diff);
+            long long days = FloorDiv<86400>(diff);
+            days += (diff < 0) & (diff != days * 86400);
+            return BasicTime(static_cast<int>(total_hours - days * 24),
+                static_cast<int>(total_minutes - total_hours * 60),
+                static_cast<int>(diff - total_minutes * 60));
         }
 
-        Time& operator-=(const Time& other) noexcept {
+        BasicTime& operator-=(const BasicTime& other) noexcept {
             *this = *this - other;
             return *this;
         }
 
-        bool operator==(const Time& other) const noexcept {
+        bool operator==(const BasicTime& other) const noexcept {
             return hours == other.hours && minutes == other.minutes && seconds == other.seconds;
         }
 
         static int GetCount() noexcept {
-            return count;
+            return TimeLifetime<Policy>::Count();
         }
 
         friend class SimpleWatch; // Декларируем SimpleWatch как дружественный класс
         friend class Watch; // Декларируем Watch как дружественный класс
 };
 
-int Time::count = 0;
+using Time = BasicTime<TIME_LIFETIME_POLICY>;
 
 class SimpleWatch {
     public:
@@ -0,0 +1,556 @@
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <streambuf>
+#include <thread>
+#include <vector>
+#include "perf_harness.hpp"
+#include "time.hpp"
+#include "clock_fleet.hpp"
+#include "time_column.hpp"
+#include "time_parser.hpp"
+#include "time_format.hpp"
+
+// Поток, который отбрасывает весь вывод: конструкторы и Print пишут в cout,
+// а в замерах нас интересует стоимость самих операций, а не терминала.
+class NullBuffer : public std::streambuf {
+    protected:
+        int overflow(int c) override { return c; }
+        std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+};
+
+static const int iterations = 1000000;
+static volatile int sink;
+
+template <class Policy>
+static void BenchLifetime(PerfHarness& perf, const char* name) {
+    perf.start();
+    for (int i = 0; i < iterations; ++i) {
+        BasicTime<Policy> t(i % 24, i % 60, i % 60);
+        sink = t.ToSeconds();
+    }
+    perf.stop(name, iterations);
+}
+
+// Одновременное создание из многих потоков: счётчик шардирован, поэтому
+// время на объект не должно расти с числом потоков.
+static void BenchConcurrentLifetime(PerfHarness& perf) {
+    for (int threads = 1; threads <= 16; threads *= 2) {
+        char name[64];
+        snprintf(name, sizeof(name), "time/construct+destroy counting x%d", threads);
+        perf.start();
+        vector<thread> workers;
+        for (int t = 0; t < threads; ++t) {
+            workers.emplace_back([threads] {
+                for (int i = 0; i < iterations / threads; ++i) {
+                    BasicTime<CountingPolicy> time(i % 24, i % 60, i % 60);
+                    sink = time.ToSeconds();
+                }
+            });
+        }
+        for (thread& worker : workers) {
+            worker.join();
+        }
+        perf.stop(name, iterations / threads * threads);
+    }
+}
+
+static void BenchArithmetic(PerfHarness& perf) {
+    Time base(23, 59, 59);
+    SimpleWatch watch;
+
+    perf.start();
+    for (int i = 0; i < iterations; ++i) {
+        watch.SetTime(base, i % 30, i % 90, i % 120);
+        sink = base.ToSeconds();
+    }
+    perf.stop("time/SetTime+Normalize", iterations);
+
+    Time other(1, 2, 3);
+    perf.start();
+    int equal = 0;
+    for (int i = 0; i < iterations; ++i) {
+        equal += base == other;
+        sink = base.ToSeconds() + other.ToSeconds();
+    }
+    perf.stop("time/ToSeconds+operator==", iterations);
+    sink = equal;
+
+    perf.start();
+    for (int i = 0; i < iterations / 10; ++i) {
+        Time diff = base - other;
+        sink = diff.ToSeconds();
+    }
+    perf.stop("time/operator-", iterations / 10);
+}
+
+// Прежняя нормализация трёх полей: переносы с ветвлениями по знаку и
+// аппаратное деление, как в Time до перехода на FloorDiv.
+static void LegacyNormalize(int& hours, int& minutes, int& seconds) {
+    if (seconds < 0) {
+        int sec_from_min = (-seconds + 59) / 60;
+        minutes -= sec_from_min;
+        seconds += sec_from_min * 60;
+    } else if (seconds > 59) {
+        minutes += seconds / 60;
+        seconds %= 60;
+    }
+
+    if (minutes < 0) {
+        int min_from_hour = (-minutes + 59) / 60;
+        hours -= min_from_hour;
+        minutes += min_from_hour * 60;
+    } else if (minutes > 59) {
+        hours += minutes / 60;
+        minutes %= 60;
+    }
+
+    if (hours > 23) {
+        hours %= 24;
+    }
+}
+
+// Та же раскладка через одно число и FloorDiv, без ветвлений.
+static void FloorDivNormalize(int& hours, int& minutes, int& seconds) {
+    long long rest = minutes * 60LL + seconds;
+    long long total_minutes = FloorDiv<60>(rest);
+    long long carry = FloorDiv<3600>(rest);
+    seconds = static_cast<int>(rest - total_minutes * 60);
+    minutes = static_cast<int>(total_minutes - carry * 60);
+    long long h = hours + carry;
+    long long wrapped = h - FloorDiv<24>(h) * 24;
+    hours = static_cast<int>(h > 23 ? wrapped : h);
+}
+
+// Случайные знаки делают ветвления прежнего кода непредсказуемыми -
+// именно так выглядят разности и сдвиги времени в реальных данных.
+template <void (*Normalize)(int&, int&, int&)>
+static void BenchNormalize(PerfHarness& perf, const char* name, const vector<int>& input) {
+    long long total = 0;
+    perf.start();
+    for (size_t i = 0; i + 3 <= input.size(); i += 3) {
+        int h = input[i], m = input[i + 1], s = input[i + 2];
+        Normalize(h, m, s);
+        total += h + m + s;
+    }
+    perf.stop(name, static_cast<long>(input.size() / 3));
+    sink = static_cast<int>(total);
+}
+
+static void BenchFromSeconds(PerfHarness& perf, const vector<int>& input) {
+    long long total = 0;
+    perf.start();
+    for (int value : input) {
+        int h = 0, m = 0, s = value;
+        LegacyNormalize(h, m, s);
+        total += h + m + s;
+    }
+    perf.stop("time/from seconds legacy", static_cast<long>(input.size()));
+
+    perf.start();
+    for (int value : input) {
+        int h = 0, m = 0, s = value;
+        FloorDivNormalize(h, m, s);
+        total += h + m + s;
+    }
+    perf.stop("time/from seconds FloorDiv", static_cast<long>(input.size()));
+
+    perf.start();
+    for (int value : input) {
+        total += BasicTime<SilentPolicy>::FromSeconds(value < 0 ? -value : value).ToSeconds();
+    }
+    perf.stop("time/Time::FromSeconds packed", static_cast<long>(input.size()));
+    sink = static_cast<int>(total);
+}
+
+static void BenchNormalization(PerfHarness& perf) {
+    mt19937 rng(42);
+    uniform_int_distribution<int> field(-200, 200);
+    vector<int> fields(3 * iterations);
+    for (int& value : fields) {
+        value = field(rng);
+    }
+    BenchNormalize<LegacyNormalize>(perf, "time/normalize legacy", fields);
+    BenchNormalize<FloorDivNormalize>(perf, "time/normalize FloorDiv", fields);
+
+    uniform_int_distribution<int> seconds(-3 * 86400, 3 * 86400);
+    vector<int> totals(iterations);
+    for (int& value : totals) {
+        value = seconds(rng);
+    }
+    BenchFromSeconds(perf, totals);
+}
+
+// Большая таблица времён: упакованный Time занимает 4 байта, и проход
+// по таблице упирается в память, а не в разбор трёх полей.
+static void BenchTable(PerfHarness& perf) {
+    const int n = 10000000;
+    vector<BasicTime<SilentPolicy>> table;
+    table.reserve(n);
+    for (int i = 0; i < n; ++i) {
+        table.emplace_back(i / 3600 % 24, i / 60 % 60, i % 60);
+    }
+
+    long long total = 0;
+    perf.start();
+    for (const BasicTime<SilentPolicy>& t : table) {
+        total += t.ToSeconds();
+    }
+    perf.stop("time/table ToSeconds scan", n);
+
+    BasicTime<SilentPolicy> noon(12, 0, 0);
+    int matches = 0;
+    perf.start();
+    for (const BasicTime<SilentPolicy>& t : table) {
+        matches += t == noon;
+    }
+    perf.stop("time/table operator== scan", n);
+    sink = static_cast<int>(total) + matches;
+    printf("%-40s %10zu bytes/element\n", "time/table element size", sizeof(BasicTime<SilentPolicy>));
+}
+
+// Пакетные операции столбца против того же по одному Time. При 4 байтах на
+// значение AVX2-ядра упираются в пропускную способность памяти. Выходные
+// буферы заполняются заранее, чтобы в замер не попадали первые обращения
+// к страницам.
+static void BenchColumnKernels(PerfHarness& perf, const char* kind, bool simd, const vector<int>& totals) {
+    char name[64];
+    TimeColumn column(simd);
+    column.AppendSeconds(totals.data(), totals.size());
+    column.Clear();
+    snprintf(name, sizeof(name), "column/%s normalize", kind);
+    perf.start();
+    column.AppendSeconds(totals.data(), totals.size());
+    perf.stop(name, static_cast<long>(totals.size()));
+
+    TimeColumn diff(simd);
+    BasicTime<SilentPolicy> noon(12, 0, 0);
+    column.Difference(noon, diff);
+    snprintf(name, sizeof(name), "column/%s difference scalar", kind);
+    perf.start();
+    column.Difference(noon, diff);
+    perf.stop(name, static_cast<long>(column.Size()));
+
+    snprintf(name, sizeof(name), "column/%s difference column", kind);
+    perf.start();
+    column.Difference(diff, diff);
+    perf.stop(name, static_cast<long>(column.Size()));
+
+    vector<uint8_t> mask;
+    snprintf(name, sizeof(name), "column/%s equal mask", kind);
+    perf.start();
+    column.Equal(noon, mask);
+    perf.stop(name, static_cast<long>(column.Size()));
+    size_t matches = TimeColumn::CountSet(mask);
+
+    snprintf(name, sizeof(name), "column/%s range mask", kind);
+    perf.start();
+    column.InRange(BasicTime<SilentPolicy>(22, 0, 0), BasicTime<SilentPolicy>(6, 0, 0), mask);
+    perf.stop(name, static_cast<long>(column.Size()));
+
+    vector<int> seconds(column.Size());
+    snprintf(name, sizeof(name), "column/%s to seconds", kind);
+    perf.start();
+    column.ToSeconds(seconds);
+    perf.stop(name, static_cast<long>(column.Size()));
+    sink = static_cast<int>(matches + TimeColumn::CountSet(mask)) + seconds[seconds.size() / 2] + static_cast<int>(diff.Data()[7]);
+}
+
+static void BenchColumn(PerfHarness& perf) {
+    const int n = 10000000;
+    mt19937 rng(7);
+    uniform_int_distribution<int> seconds(-5 * 86400, 5 * 86400);
+    vector<int> totals(n);
+    for (int& value : totals) {
+        value = seconds(rng);
+    }
+
+    vector<BasicTime<SilentPolicy>> objects;
+    objects.reserve(n);
+    perf.start();
+    for (int value : totals) {
+        objects.push_back(BasicTime<SilentPolicy>::FromSeconds(value < 0 ? 0 : value));
+    }
+    perf.stop("column/per-object FromSeconds", n);
+
+    BasicTime<SilentPolicy> noon(12, 0, 0);
+    vector<BasicTime<SilentPolicy>> diff;
+    diff.reserve(n);
+    perf.start();
+    for (const BasicTime<SilentPolicy>& t : objects) {
+        diff.push_back(t - noon);
+    }
+    perf.stop("column/per-object operator-", n);
+
+    int matches = 0;
+    perf.start();
+    for (const BasicTime<SilentPolicy>& t : objects) {
+        matches += t == noon;
+    }
+    perf.stop("column/per-object operator==", n);
+    sink = matches + diff[n / 2].ToSeconds();
+
+    BenchColumnKernels(perf, "scalar", false, totals);
+    if (TimeColumn(true).Vectorized()) {
+        BenchColumnKernels(perf, "avx2", true, totals);
+    }
+}
+
+// Загрузка файла HH:MM:SS: прежний путь через >> против TimeParser в одном
+// и в нескольких потоках. Каждая тысячная строка записана без ведущих нулей.
+static void BenchParser(PerfHarness& perf) {
+    const int n = 10000000;
+    string path = (filesystem::temp_directory_path() / "time_parser_bench.txt").string();
+    {
+        ofstream file(path, ios::binary);
+        char line[32];
+        for (int i = 0; i < n; ++i) {
+            int t = static_cast<int>((i * 7919LL) % 86400);
+            const char* format = i % 1000 == 0 ? "%d:%d:%d\n" : "%02d:%02d:%02d\n";
+            int length = snprintf(line, sizeof(line), format, t / 3600, t / 60 % 60, t % 60);
+            file.write(line, length);
+        }
+    }
+
+    perf.start();
+    {
+        ifstream file(path);
+        vector<BasicTime<SilentPolicy>> times;
+        times.reserve(n);
+        int h, m, s;
+        char colon;
+        while (file >> h >> colon >> m >> colon >> s) {
+            times.emplace_back(h, m, s);
+        }
+        sink = static_cast<int>(times.size());
+    }
+    perf.stop("parse/iostream >> into vector<Time>", n);
+
+    int threads = static_cast<int>(thread::hardware_concurrency());
+    if (threads < 4) {
+        threads = 4;
+    }
+    for (int count : {1, threads}) {
+        char name[64];
+        snprintf(name, sizeof(name), "parse/TimeParser mmap x%d", count);
+        TimeColumn column;
+        perf.start();
+        TimeParseResult result = TimeParser::ParseFile(path, column, count);
+        perf.stop(name, n);
+        sink = static_cast<int>(result.parsed + result.bad_lines);
+    }
+    remove(path.c_str());
+}
+
+// Выгрузка столбца в файл: прежний вывод через поток с endl на каждой
+// строке против TimeWriter, который форматирует по таблице двух цифр и
+// отдаёт столбец одним write().
+static void BenchFormat(PerfHarness& perf) {
+    const int n = 1000000;
+    vector<int> totals(n);
+    for (int i = 0; i < n; ++i) {
+        totals[i] = static_cast<int>((i * 7919LL) % 86400);
+    }
+    TimeColumn column;
+    column.AppendSeconds(totals.data(), totals.size());
+    string path = (filesystem::temp_directory_path() / "time_format_bench.txt").string();
+
+    perf.start();
+    {
+        ofstream file(path);
+        for (size_t i = 0; i < column.Size(); ++i) {
+            uint32_t s = column.Data()[i];
+            file << s / 3600 << ":" << s / 60 % 60 << ":" << s % 60 << endl;
+        }
+    }
+    perf.stop("format/ofstream << endl", n);
+
+    vector<char> buffer(n * (time12_length + 1));
+    perf.start();
+    char* out = buffer.data();
+    for (size_t i = 0; i < column.Size(); ++i) {
+        out = FormatTime24(column.Data()[i], out);
+        *out++ = '\n';
+    }
+    perf.stop("format/FormatTime24 into buffer", n);
+
+    perf.start();
+    out = buffer.data();
+    for (size_t i = 0; i < column.Size(); ++i) {
+        out = FormatTime12(column.Data()[i], out);
+        *out++ = '\n';
+    }
+    perf.stop("format/FormatTime12 into buffer", n);
+    sink = buffer[n / 2];
+
+#ifdef __linux__
+    for (bool format24 : {true, false}) {
+        int fd = open(path.c_str(), O_WRONLY | O_TRUNC | O_CLOEXEC);
+        perf.start();
+        {
+            TimeWriter writer(fd, format24);
+            writer.AddColumn(column.Data(), column.Size());
+        }
+        perf.stop(format24 ? "format/TimeWriter column 24h" : "format/TimeWriter column 12h", n);
+        close(fd);
+    }
+#endif
+    remove(path.c_str());
+}
+
+// Кадр экрана с 10000 часов: текст каждых рендерится в общий буфер кадра.
+static void BenchDashboard(PerfHarness& perf) {
+    const int watches = 10000;
+    const int frames = 100;
+    vector<Time> times;
+    times.reserve(watches);
+    for (int i = 0; i < watches; ++i) {
+        times.push_back(Time::FromSeconds(static_cast<int>((i * 7919LL) % 86400)));
+    }
+    vector<char> frame(watches * WatchTextTable::slot);
+    for (bool cached : {false, true}) {
+        for (bool format24 : {true, false}) {
+            Watch watch(format24, cached);
+            perf.start();
+            for (int f = 0; f < frames; ++f) {
+                char* out = frame.data();
+                for (const Time& t : times) {
+                    watch.Render(t, out);
+                    out += WatchTextTable::slot;
+                }
+            }
+            char name[64];
+            snprintf(name, sizeof(name), "dashboard/Watch::Render %s%s", format24 ? "24h" : "12h", cached ? " cached" : "");
+            perf.stop(name, static_cast<long>(watches) * frames);
+            sink = frame[watches / 2];
+        }
+    }
+}
+
+// 100000 часов четырёх видов: vector<unique_ptr<Clock>> с виртуальными
+// вызовами против ClockFleet с векторами по видам. Указатели перемешаны,
+// как в долго живущем парке, где часы добавляются и удаляются вразнобой.
+static void BenchFleet(PerfHarness& perf) {
+    const int clocks = 100000;
+    const int rounds = 20;
+    vector<unique_ptr<Clock>> pointers;
+    pointers.reserve(clocks);
+    ClockFleet fleet;
+    fleet.Reserve<CuckooClock>(clocks / 4);
+    fleet.Reserve<WallClock>(clocks / 4);
+    fleet.Reserve<WristWatch>(clocks / 4);
+    fleet.Reserve<SmartWatch>(clocks / 4);
+    for (int i = 0; i < clocks; ++i) {
+        int h = i % 24, m = i % 60, s = i / 60 % 60;
+        switch (i % 4) {
+        case 0:
+            pointers.push_back(make_unique<CuckooClock>(h, m, s));
+            fleet.Add<CuckooClock>(h, m, s);
+            break;
+        case 1:
+            pointers.push_back(make_unique<WallClock>(h, m, s));
+            fleet.Add<WallClock>(h, m, s);
+            break;
+        case 2:
+            pointers.push_back(make_unique<WristWatch>(h, m, s));
+            fleet.Add<WristWatch>(h, m, s);
+            break;
+        default:
+            pointers.push_back(make_unique<SmartWatch>(h, m, s));
+            fleet.Add<SmartWatch>(h, m, s);
+            break;
+        }
+    }
+
+    shuffle(pointers.begin(), pointers.end(), mt19937(11));
+
+    perf.start();
+    for (int r = 0; r < rounds; ++r) {
+        for (const unique_ptr<Clock>& clock : pointers) {
+            clock->time.Advance(1);
+        }
+    }
+    perf.stop("fleet/advance unique_ptr<Clock>", static_cast<long>(clocks) * rounds);
+
+    perf.start();
+    for (int r = 0; r < rounds; ++r) {
+        fleet.AdvanceAll(1);
+    }
+    perf.stop("fleet/advance ClockFleet", static_cast<long>(clocks) * rounds);
+
+    string text(clocks * Clock::max_line, '\0');
+    perf.start();
+    for (int r = 0; r < rounds; ++r) {
+        char* end = &text[0];
+        for (const unique_ptr<Clock>& clock : pointers) {
+            end = clock->Render(end);
+        }
+        sink = static_cast<int>(end - text.data());
+    }
+    perf.stop("fleet/render unique_ptr<Clock> virtual", static_cast<long>(clocks) * rounds);
+
+    perf.start();
+    for (int r = 0; r < rounds; ++r) {
+        sink = static_cast<int>(fleet.RenderAll(&text[0]) - text.data());
+    }
+    perf.stop("fleet/render ClockFleet", static_cast<long>(clocks) * rounds);
+}
+
+static void BenchOutput(PerfHarness& perf) {
+    Time t(12, 34, 56);
+    Watch watch(false);
+    perf.start();
+    for (int i = 0; i < iterations; ++i) {
+        t.Print();
+    }
+    perf.stop("time/Print", iterations);
+
+    perf.start();
+    for (int i = 0; i < iterations; ++i) {
+        watch.ShowTime(t);
+    }
+    perf.stop("time/Watch::ShowTime 12h", iterations);
+
+    Watch cached(false, true);
+    perf.start();
+    for (int i = 0; i < iterations; ++i) {
+        cached.ShowTime(t);
+    }
+    perf.stop("time/Watch::ShowTime 12h cached", iterations);
+
+    CuckooClock cuckoo(1, 2, 3);
+    WallClock wall(4, 5, 6);
+    WristWatch wrist(7, 8, 9);
+    SmartWatch smart(10, 11, 12);
+    const Clock* clocks[4] = {&cuckoo, &wall, &wrist, &smart};
+    perf.start();
+    for (int i = 0; i < iterations; ++i) {
+        clocks[i % 4]->ShowTime();
+    }
+    perf.stop("time/Clock::ShowTime virtual", iterations);
+}
+
+int main(int argc, char** argv) {
+    PerfHarness perf(argc, argv);
+    NullBuffer null_buffer;
+    std::streambuf* console = std::cout.rdbuf(&null_buffer);
+    BenchLifetime<TracingPolicy>(perf, "time/construct+destroy tracing");
+    BenchLifetime<CountingPolicy>(perf, "time/construct+destroy counting");
+    BenchLifetime<SilentPolicy>(perf, "time/construct+destroy silent");
+    BenchConcurrentLifetime(perf);
+    BenchArithmetic(perf);
+    BenchNormalization(perf);
+    BenchTable(perf);
+    BenchColumn(perf);
+    BenchParser(perf);
+    BenchFormat(perf);
+    BenchDashboard(perf);
+    BenchFleet(perf);
+    BenchOutput(perf);
+    std::cout.rdbuf(console);
+    return 0;
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include "time.hpp"
+
+// Парк часов без указателей на базовый класс: часы каждого вида лежат в своём
+// непрерывном векторе, а обход вызывает методы конкретного типа напрямую -
+// квалифицированный вызов Kind::Render не идёт через vtable и встраивается.
+// Обход идёт по видам в порядке Kinds, внутри вида - в порядке добавления.
+template <class... Kinds>
+class BasicClockFleet {
+    private:
+        tuple<vector<Kinds>...> kinds;
+
+        template <class List, class F>
+        static void ForEachIn(List& list, F& f) {
+            for (auto& clock : list) {
+                f(clock);
+            }
+        }
+
+    public:
+        template <class Kind, class... Args>
+        Kind& Add(Args&&... args) {
+            return get<vector<Kind>>(kinds).emplace_back(forward<Args>(args)...);
+        }
+
+        // Заранее выделенное место: при росте вектора часы копируются, а
+        // копии и разрушения видны в счётчиках и трассировке.
+        template <class Kind>
+        void Reserve(size_t n) {
+            get<vector<Kind>>(kinds).reserve(n);
+        }
+
+        template <class Kind>
+        const vector<Kind>& Of() const noexcept {
+            return get<vector<Kind>>(kinds);
+        }
+
+        size_t Size() const noexcept {
+            return (get<vector<Kinds>>(kinds).size() + ...);
+        }
+
+        // f вызывается с ссылкой на часы их настоящего типа.
+        template <class F>
+        void ForEach(F&& f) {
+            apply([&f](auto&... lists) { (ForEachIn(lists, f), ...); }, kinds);
+        }
+
+        template <class F>
+        void ForEach(F&& f) const {
+            apply([&f](const auto&... lists) { (ForEachIn(lists, f), ...); }, kinds);
+        }
+
+        void AdvanceAll(long long seconds) noexcept {
+            ForEach([seconds](auto& clock) { clock.time.Advance(seconds); });
+        }
+
+        // Пишет строки ShowTime всех часов подряд; в out должно быть
+        // Size() * Clock::max_line байт. Возвращает конец текста.
+        char* RenderAll(char* out) const {
+            ForEach([&out](const auto& clock) {
+                using Kind = decay_t<decltype(clock)>;
+                out = clock.Kind::Render(out);
+            });
+            return out;
+        }
+
+        // Добавляет в out строки ShowTime всех часов.
+        void RenderAll(string& out) const {
+            size_t used = out.size();
+            out.resize(used + Size() * Clock::max_line);
+            char* end = RenderAll(&out[used]);
+            out.resize(static_cast<size_t>(end - out.data()));
+        }
+
+        // ShowTime всех часов одним выводом.
+        void ShowAll() const {
+            string text;
+            RenderAll(text);
+            cout.write(text.data(), static_cast<streamsize>(text.size()));
+        }
+};
+
+using ClockFleet = BasicClockFleet<CuckooClock, WallClock, WristWatch, SmartWatch>;
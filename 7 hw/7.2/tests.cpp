@@ -1,34 +1,34 @@
 #include <gtest/gtest.h>
-#include "time.h"
+#include "time.hpp"
 
 // тест конструктора 
 TEST(TimeTest, Constructor) {
     Time t1(1, 2, 3);
-    EXPECT_EQ(t1.hours, 1);
-    EXPECT_EQ(t1.minutes, 2);
-    EXPECT_EQ(t1.seconds, 3);
+    EXPECT_EQ(t1.Hours(), 1);
+    EXPECT_EQ(t1.Minutes(), 2);
+    EXPECT_EQ(t1.Seconds(), 3);
     
     Time t2(25, 61, 61);
-    EXPECT_EQ(t2.hours, 2);
-    EXPECT_EQ(t2.minutes, 2);
-    EXPECT_EQ(t2.seconds, 1);
+    EXPECT_EQ(t2.Hours(), 2);
+    EXPECT_EQ(t2.Minutes(), 2);
+    EXPECT_EQ(t2.Seconds(), 1);
 
     // провальный тест
     Time t3(0, 0, 0);
-    EXPECT_EQ(t3.hours, 1);  // должно быть 0
+    EXPECT_EQ(t3.Hours(), 1);  // должно быть 0
 }
 
 // тест метода Normalize
 TEST(TimeTest, Normalize) {
     Time t1(1, 70, 80);
-    EXPECT_EQ(t1.hours, 2);
-    EXPECT_EQ(t1.minutes, 11);
-    EXPECT_EQ(t1.seconds, 20);
+    EXPECT_EQ(t1.Hours(), 2);
+    EXPECT_EQ(t1.Minutes(), 11);
+    EXPECT_EQ(t1.Seconds(), 20);
 
     // провальный тест
     Time t2(0, 0, 0);
     t2.Normalize();
-    EXPECT_EQ(t2.minutes, 1);  // должно быть 0
+    EXPECT_EQ(t2.Minutes(), 1);  // должно быть 0
 }
 
 // тест метода ToSeconds
@@ -49,15 +49,15 @@ TEST(TimeTest, SubtractionOperator) {
     Time t1(2, 30, 0);
     Time t2(1, 15, 0);
     Time result = t1 - t2;
-    EXPECT_EQ(result.hours, 1);
-    EXPECT_EQ(result.minutes, 15);
-    EXPECT_EQ(result.seconds, 0);
+    EXPECT_EQ(result.Hours(), 1);
+    EXPECT_EQ(result.Minutes(), 15);
+    EXPECT_EQ(result.Seconds(), 0);
 
     // провальный тест
     Time t3(0, 0, 0);
     Time t4(0, 0, 0);
     result = t3 - t4;
-    EXPECT_EQ(result.hours, 1);  // должно быть 0
+    EXPECT_EQ(result.Hours(), 1);  // должно быть 0
 }
 
 // тест оператора -=
@@ -65,14 +65,14 @@ TEST(TimeTest, SubtractionAssignmentOperator) {
     Time t1(2, 30, 0);
     Time t2(1, 15, 0);
     t1 -= t2;
-    EXPECT_EQ(t1.hours, 1);
-    EXPECT_EQ(t1.minutes, 15);
-    EXPECT_EQ(t1.seconds, 0);
+    EXPECT_EQ(t1.Hours(), 1);
+    EXPECT_EQ(t1.Minutes(), 15);
+    EXPECT_EQ(t1.Seconds(), 0);
 
     // провальный тест
     Time t3(0, 0, 0);
     t3 -= t1;
-    EXPECT_EQ(t3.hours, 1);  // должно быть -1
+    EXPECT_EQ(t3.Hours(), 1);  // должно быть -1
 }
 
 // тест оператора ==
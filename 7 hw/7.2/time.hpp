@@ -1,122 +1,204 @@
+#pragma once
+
+#include <cstdint>
 #include <iostream>
 #include <stdexcept>
+#include <type_traits>
+#include "../../common/time_base.hpp"
+#include "time_format.hpp"
 using namespace std;
 
 class SimpleWatch;
 class Watch;
 
-class Time {
+// Время суток хранится одним числом - секундами от полуночи (0..86399),
+// часы, минуты и секунды вычисляются при обращении. Объект занимает 4 байта,
+// а ToSeconds, operator- и operator== сводятся к одной целочисленной операции.
+// Литеральный тип только с политикой SilentPolicy: тогда создание, арифметика
+// и сравнение работают в constexpr, остальные политики считают объекты.
+template <class Policy>
+class BasicTime : private TimeLifetime<Policy> {
     private:
-        int hours, minutes, seconds;
-        static int count; 
+        static constexpr long long seconds_per_day = 24 * 3600;
 
-    public:
-        Time(int h, int m, int s) : hours(h), minutes(m), seconds(s) {
+        uint32_t secs;
+
+        struct Fields {
+            long long total;
+        };
+
+        // Проверка выполняется до конструирования базы, поэтому при исключении
+        // счётчик и вывод не затрагиваются.
+        static constexpr Fields Checked(int h, int m, int s) {
             if (h < 0 || m < 0 || s < 0) {
                 throw invalid_argument("Negative values are not allowed for hours, minutes, or seconds.");
             }
-            Normalize();
-            count++; 
-            cout << "Constructor is called. Current count: " << count << endl;
+            return Fields{h * 3600LL + m * 60LL + s};
         }
 
-        ~Time() noexcept {
-            count--;
-            cout << "Destructor is called. Current count: " << count << endl;
+        // Приводит любое число секунд к времени суток, отрицательные
+        // значения отсчитываются назад от полуночи.
+        static constexpr uint32_t Pack(long long total) noexcept {
+            return static_cast<uint32_t>(total - FloorDiv<seconds_per_day>(total) * seconds_per_day);
         }
 
-        void Normalize() noexcept {
-            if (seconds < 0) {
-                int sec_from_min = (-seconds + 59) / 60;
-                minutes -= sec_from_min;
-                seconds += sec_from_min * 60;
-            } else if (seconds > 59) {
-                minutes += seconds / 60;
-                seconds %= 60;
-            }
+        explicit constexpr BasicTime(Fields f) noexcept : secs(Pack(f.total)) {}
 
-            if (minutes < 0) {
-                int min_from_hour = (-minutes + 59) / 60;
-                hours -= min_from_hour;
-                minutes += min_from_hour * 60;
-            } else if (minutes > 59) {
-                hours += minutes / 60;
-                minutes %= 60;
-            }
+    public:
+        constexpr BasicTime(int h, int m, int s) : BasicTime(Checked(h, m, s)) {}
 
-            if (hours > 23) {
-                hours %= 24;
-            }
+        // То же, что BasicTime(0, 0, total).
+        static constexpr BasicTime FromSeconds(int total) {
+            return BasicTime(0, 0, total);
+        }
+
+        // Копия из Time с другой политикой, например из литерала "10:20:30"_t.
+        template <class Other>
+        constexpr BasicTime(const BasicTime<Other>& other) noexcept : secs(other.secs) {}
+
+        // Представление всегда нормализовано; метод оставлен для совместимости.
+        constexpr void Normalize() noexcept {}
+
+        constexpr int Hours() const noexcept {
+            return static_cast<int>(secs / 3600);
+        }
+
+        constexpr int Minutes() const noexcept {
+            return static_cast<int>(secs / 60 % 60);
+        }
+
+        constexpr int Seconds() const noexcept {
+            return static_cast<int>(secs % 60);
         }
 
-        int ToSeconds() const noexcept {
-            return hours * 3600 + minutes * 60 + seconds;
+        constexpr int ToSeconds() const noexcept {
+            return static_cast<int>(secs);
         }
 
+        // Прежний вид без ведущих нулей; строка собирается в буфере и
+        // выводится одним write без сброса потока.
         void Print() const noexcept {
-            cout << hours << ":" << minutes << ":" << seconds << endl;
+            char line[16];
+            char* end = FormatTimeShort(secs, line);
+            *end++ = '\n';
+            cout.write(line, end - line);
+        }
+
+        // "HH:MM:SS" и "HH:MM:SS AM" в буфер вызывающего, см. time_format.hpp.
+        char* Format24(char* out) const noexcept {
+            return FormatTime24(secs, out);
         }
 
-        Time operator-(const Time& other) const noexcept {
-            int totalSec1 = ToSeconds();
-            int totalSec2 = other.ToSeconds();
-            int diff = totalSec1 - totalSec2;
+        char* Format12(char* out) const noexcept {
+            return FormatTime12(secs, out);
+        }
 
-            int newHours = (diff / 3600) % 24;
-            diff %= 3600;
-            int newMinutes = diff / 60;
-            int newSeconds = diff % 60;
+        // Разность по модулю суток: 01:00:00 - 02:00:00 = 23:00:00.
+        constexpr BasicTime operator-(const BasicTime& other) const noexcept {
+            return BasicTime(Fields{static_cast<long long>(secs) - other.secs});
+        }
 
-            return Time(newHours, newMinutes, newSeconds);
+        constexpr BasicTime& operator-=(const BasicTime& other) noexcept {
+            secs = Pack(static_cast<long long>(secs) - other.secs);
+            return *this;
         }
 
-        Time& operator-=(const Time& other) noexcept {
-            *this = *this - other;
+        // Сдвиг на seconds вперёд (назад при отрицательном) по модулю суток.
+        // Целые сутки отбрасываются до сложения: сумма остаётся в пределах
+        // точности Pack и не переполняется при любом seconds.
+        constexpr BasicTime& Advance(long long seconds) noexcept {
+            secs = Pack(secs + seconds % seconds_per_day);
             return *this;
         }
 
-        bool operator==(const Time& other) const noexcept {
-            return hours == other.hours && minutes == other.minutes && seconds == other.seconds;
+        constexpr bool operator==(const BasicTime& other) const noexcept {
+            return secs == other.secs;
         }
 
         static int GetCount() noexcept {
-            return count;
+            return TimeLifetime<Policy>::Count();
         }
 
+        template <class Other>
+        friend class BasicTime;
         friend class SimpleWatch;
         friend class Watch;
 };
 
-int Time::count = 0;
+// Time по умолчанию (TracingPolicy) считает объекты и пишет в cout, поэтому
+// он не литеральный тип и в constexpr не годится. Вычисления на этапе
+// компиляции - только через BasicTime<SilentPolicy> (его же возвращает _t);
+// Time из него строится неявным преобразованием.
+static_assert(is_trivially_destructible_v<BasicTime<SilentPolicy>>,
+              "BasicTime<SilentPolicy> must stay a literal type");
+
+using Time = BasicTime<TIME_LIFETIME_POLICY>;
+
+// Читает поле из одной-двух цифр и следующий за ним разделитель
+// (end == 0 - поле должно заканчивать строку).
+consteval int ParseTimeField(const char* text, size_t length, size_t& pos, int min_digits, int limit, char end) {
+    int value = 0;
+    int digits = 0;
+    while (pos < length && text[pos] >= '0' && text[pos] <= '9' && digits < 2) {
+        value = value * 10 + (text[pos] - '0');
+        ++pos;
+        ++digits;
+    }
+    bool ended = end == 0 ? pos == length : pos < length && text[pos++] == end;
+    if (digits < min_digits || value >= limit || !ended) {
+        throw invalid_argument("Time literal must look like HH:MM:SS within one day.");
+    }
+    return value;
+}
+
+// Литерал "HH:MM:SS"_t (часы могут быть одной цифрой) разбирается при
+// компиляции; неверная строка или значение вне суток - ошибка сборки.
+consteval BasicTime<SilentPolicy> operator""_t(const char* text, size_t length) {
+    size_t pos = 0;
+    int h = ParseTimeField(text, length, pos, 1, 24, ':');
+    int m = ParseTimeField(text, length, pos, 2, 60, ':');
+    int s = ParseTimeField(text, length, pos, 2, 60, 0);
+    return BasicTime<SilentPolicy>(h, m, s);
+}
 
 class SimpleWatch {
     public:
         void ShowTime(const Time& t) const {
-            cout << "SimpleWatch: " << t.hours << ":" << t.minutes << ":" << t.seconds << endl;
+            char line[64] = "SimpleWatch: ";
+            char* end = FormatTimeShort(t.secs, line + strlen(line));
+            *end++ = '\n';
+            cout.write(line, end - line);
         }
 
         void SetTime(Time& t, int h, int m, int s) {
-            t.hours = h;
-            t.minutes = m;
-            t.seconds = s;
-            t.Normalize();
+            t.secs = Time::Pack(h * 3600LL + m * 60LL + s);
         }
 };
 
 class Watch {
     private:
         bool is24HourFormat;
+        const WatchTextTable* table;
 
     public:
-        Watch(bool format24 = true) : is24HourFormat(format24) {}
+        // cached - брать текст из общей WatchTextTable (для экранов, где
+        // перерисовываются тысячи часов); вывод тот же.
+        Watch(bool format24 = true, bool cached = false)
+            : is24HourFormat(format24), table(cached ? &WatchTextTable::Get() : nullptr) {}
 
         void SetFormat(bool format24) {
             is24HourFormat = format24;
         }
 
-        void ShowTime(const Time& t) const {
-            int displayHours = t.hours;
-            string period = "";
+        // Текст показа без префикса и перевода строки; в out должно быть
+        // не меньше WatchTextTable::slot байт. Возвращает конец текста.
+        char* Render(const Time& t, char* out) const noexcept {
+            if (table) {
+                return table->Render(t.secs, is24HourFormat, out);
+            }
+
+            int displayHours = t.Hours();
+            const char* period = "";
 
             if (!is24HourFormat) {
                 period = displayHours >= 12 ? " PM" : " AM";
@@ -124,91 +206,170 @@ class Watch {
                 if (displayHours == 0) displayHours = 12;
             }
 
-            cout << "Watch: " << displayHours << ":" << t.minutes << ":" << t.seconds << period << endl;
+            char* end = FormatFields(displayHours, t.Minutes(), t.Seconds(), out);
+            size_t period_length = strlen(period);
+            memcpy(end, period, period_length);
+            return end + period_length;
+        }
+
+        void ShowTime(const Time& t) const {
+            char line[64] = "Watch: ";
+            char* end = Render(t, line + strlen(line));
+            *end++ = '\n';
+            cout.write(line, end - line);
         }
 
         void SetTime(Time& t, int h, int m, int s) {
-            t.hours = h;
-            t.minutes = m;
-            t.seconds = s;
-            t.Normalize();
+            t.secs = Time::Pack(h * 3600LL + m * 60LL + s);
         }
 };
 
+// Учёт живых объектов для типов часов: свой счётчик у каждого T,
+// включается той же политикой, что и у Time.
+template <class T, class Policy = TIME_LIFETIME_POLICY, bool Counts = Policy::counts>
+class LiveObject {
+    protected:
+        LiveObject() noexcept {
+            LiveCounter<T>::Add(1);
+        }
+
+        LiveObject(const LiveObject&) noexcept {
+            LiveCounter<T>::Add(1);
+        }
+
+        LiveObject& operator=(const LiveObject&) = default;
+
+        ~LiveObject() noexcept {
+            LiveCounter<T>::Add(-1);
+        }
+
+    public:
+        static int GetCount() noexcept {
+            return static_cast<int>(LiveCounter<T>::Get());
+        }
+};
+
+template <class T, class Policy>
+class LiveObject<T, Policy, false> {
+    public:
+        static int GetCount() noexcept {
+            return 0;
+        }
+};
+
+// Сообщения конструкторов и деструкторов часов подчиняются той же политике.
+inline void TraceLifetime(const char* message) {
+    if (TIME_LIFETIME_POLICY::traces) {
+        cout << message << endl;
+    }
+}
+
 class Clock {
     public:
         Time time;
         Clock(int h, int m, int s) : time(h, m, s) {
-            cout << "Clock Constructor is called." << endl;
+            TraceLifetime("Clock Constructor is called.");
         }
 
         virtual ~Clock() {
-            cout << "Clock Destructor is called." << endl;
+            TraceLifetime("Clock Destructor is called.");
         }
 
+        // Строка ShowTime ("CuckooClock time: h:m:s\n") вместе с возможным
+        // лишним байтом после неё не длиннее max_line.
+        static constexpr size_t max_line = 64;
+
+        virtual char* Render(char* out) const = 0;
+
         virtual void ShowTime() const = 0;
+
+    protected:
+        char* RenderLine(const char* label, char* out) const noexcept {
+            size_t length = strlen(label);
+            memcpy(out, label, length);
+            out = FormatTimeShort(static_cast<uint32_t>(time.ToSeconds()), out + length);
+            *out = '\n';
+            return out + 1;
+        }
+
+        void WriteLine() const {
+            char line[max_line];
+            cout.write(line, Render(line) - line);
+        }
 };
 
-class CuckooClock : public Clock {
+class CuckooClock : public Clock, public LiveObject<CuckooClock> {
     public:
         CuckooClock(int h, int m, int s) : Clock(h, m, s) {
-            cout << "CuckooClock Constructor is called." << endl;
+            TraceLifetime("CuckooClock Constructor is called.");
         }
 
         ~CuckooClock() {
-            cout << "CuckooClock Destructor is called." << endl;
+            TraceLifetime("CuckooClock Destructor is called.");
+        }
+
+        char* Render(char* out) const override {
+            return RenderLine("CuckooClock time: ", out);
         }
 
         void ShowTime() const override {
-            cout << "CuckooClock time: ";
-            time.Print();
+            WriteLine();
         }
 };
 
-class WallClock : public Clock {
+class WallClock : public Clock, public LiveObject<WallClock> {
     public:
         WallClock(int h, int m, int s) : Clock(h, m, s) {
-            cout << "WallClock Constructor is called." << endl;
+            TraceLifetime("WallClock Constructor is called.");
         }
 
         ~WallClock() {
-            cout << "WallClock Destructor is called." << endl;
+            TraceLifetime("WallClock Destructor is called.");
+        }
+
+        char* Render(char* out) const override {
+            return RenderLine("WallClock time: ", out);
         }
 
         void ShowTime() const override {
-            cout << "WallClock time: ";
-            time.Print();
+            WriteLine();
         }
 };
 
-class WristWatch : public Clock {
+class WristWatch : public Clock, public LiveObject<WristWatch> {
     public:
         WristWatch(int h, int m, int s) : Clock(h, m, s) {
-            cout << "WristWatch Constructor is called." << endl;
+            TraceLifetime("WristWatch Constructor is called.");
         }
 
         ~WristWatch() {
-            cout << "WristWatch Destructor is called." << endl;
+            TraceLifetime("WristWatch Destructor is called.");
+        }
+
+        char* Render(char* out) const override {
+            return RenderLine("WristWatch time: ", out);
         }
 
         void ShowTime() const override {
-            cout << "WristWatch time: ";
-            time.Print();
+            WriteLine();
         }
 };
 
-class SmartWatch : public Clock {
+class SmartWatch : public Clock, public LiveObject<SmartWatch> {
     public:
         SmartWatch(int h, int m, int s) : Clock(h, m, s) {
-            cout << "SmartWatch Constructor is called." << endl;
+            TraceLifetime("SmartWatch Constructor is called.");
         }
 
         ~SmartWatch() {
-            cout << "SmartWatch Destructor is called." << endl;
+            TraceLifetime("SmartWatch Destructor is called.");
+        }
+
+        char* Render(char* out) const override {
+            return RenderLine("SmartWatch time: ", out);
         }
 
         void ShowTime() const override {
-            cout << "SmartWatch time: ";
-            time.Print();
+            WriteLine();
         }
 };
@@ -0,0 +1,238 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+#include "time.hpp"
+
+// AVX2-ядра собираются для x86-64 с атрибутом target и выбираются при
+// запуске, поэтому особых флагов компилятора не нужно; -DTIME_COLUMN_NO_SIMD
+// оставляет только скалярные циклы.
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__)) && !defined(TIME_COLUMN_NO_SIMD)
+#include <immintrin.h>
+#define TIME_COLUMN_AVX2 1
+#define TIME_COLUMN_AVX2_TARGET __attribute__((target("avx2")))
+#endif
+
+// Столбец времён суток: секунды от полуночи подряд в одном массиве, по 4 байта
+// на значение, как у упакованного Time. Операции выполняются над всем столбцом
+// сразу: с AVX2 по 8 значений за инструкцию, иначе скалярным циклом с тем же
+// результатом. Маски - по биту на элемент, младший бит байта i соответствует
+// элементу 8 * i.
+class TimeParser;
+
+class TimeColumn {
+    private:
+        friend class TimeParser;
+
+        static constexpr int32_t seconds_per_day = 24 * 3600;
+
+        vector<uint32_t> secs;
+        bool simd;
+
+        static bool CpuHasAvx2() noexcept {
+#ifdef TIME_COLUMN_AVX2
+            static const bool has = __builtin_cpu_supports("avx2");
+            return has;
+#else
+            return false;
+#endif
+        }
+
+        static void WrapScalar(const int* in, uint32_t* out, size_t n) noexcept {
+            for (size_t i = 0; i < n; ++i) {
+                out[i] = static_cast<uint32_t>(in[i] - FloorDiv<seconds_per_day>(in[i]) * seconds_per_day);
+            }
+        }
+
+        static void DifferenceScalar(const uint32_t* a, const uint32_t* b, size_t b_step, uint32_t* out, size_t n) noexcept {
+            for (size_t i = 0; i < n; ++i) {
+                int32_t d = static_cast<int32_t>(a[i]) - static_cast<int32_t>(b[i * b_step]);
+                out[i] = static_cast<uint32_t>(d + (d < 0 ? seconds_per_day : 0));
+            }
+        }
+
+        // Бит i маски - lo <= a[i] <= hi, при wrap - a[i] >= lo или a[i] <= hi.
+        static void RangeScalar(const uint32_t* a, size_t n, uint32_t lo, uint32_t hi, bool wrap, uint8_t* mask) noexcept {
+            for (size_t i = 0; i < n; i += 8) {
+                uint8_t bits = 0;
+                for (size_t j = 0; j < 8 && i + j < n; ++j) {
+                    bool above = a[i + j] >= lo;
+                    bool below = a[i + j] <= hi;
+                    bits |= static_cast<uint8_t>((wrap ? above || below : above && below) << j);
+                }
+                mask[i / 8] = bits;
+            }
+        }
+
+#ifdef TIME_COLUMN_AVX2
+        // Частное оценивается во float (ошибка меньше единицы для любого int),
+        // остаток считается точно в целых и доводится до [0, 86400) двумя
+        // поправками на сутки.
+        TIME_COLUMN_AVX2_TARGET static void WrapAvx2(const int* in, uint32_t* out, size_t n) noexcept {
+            const __m256 inverse = _mm256_set1_ps(1.0f / seconds_per_day);
+            const __m256i day = _mm256_set1_epi32(seconds_per_day);
+            const __m256i zero = _mm256_setzero_si256();
+            size_t i = 0;
+            for (; i + 8 <= n; i += 8) {
+                __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+                __m256 estimate = _mm256_floor_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(x), inverse));
+                __m256i r = _mm256_sub_epi32(x, _mm256_mullo_epi32(_mm256_cvttps_epi32(estimate), day));
+                r = _mm256_add_epi32(r, _mm256_and_si256(_mm256_cmpgt_epi32(zero, r), day));
+                r = _mm256_sub_epi32(r, _mm256_andnot_si256(_mm256_cmpgt_epi32(day, r), day));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), r);
+            }
+            WrapScalar(in + i, out + i, n - i);
+        }
+
+        // b_step 0 - вычитается одно значение *b, 1 - поэлементно.
+        TIME_COLUMN_AVX2_TARGET static void DifferenceAvx2(const uint32_t* a, const uint32_t* b, size_t b_step, uint32_t* out, size_t n) noexcept {
+            const __m256i day = _mm256_set1_epi32(seconds_per_day);
+            const __m256i zero = _mm256_setzero_si256();
+            const __m256i scalar = _mm256_set1_epi32(static_cast<int>(*b));
+            size_t i = 0;
+            for (; i + 8 <= n; i += 8) {
+                __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+                __m256i y = b_step ? _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i)) : scalar;
+                __m256i d = _mm256_sub_epi32(x, y);
+                d = _mm256_add_epi32(d, _mm256_and_si256(_mm256_cmpgt_epi32(zero, d), day));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), d);
+            }
+            DifferenceScalar(a + i, b + i * b_step, b_step, out + i, n - i);
+        }
+
+        // Значения меньше 2^31, поэтому знаковое сравнение AVX2 подходит.
+        TIME_COLUMN_AVX2_TARGET static void RangeAvx2(const uint32_t* a, size_t n, uint32_t lo, uint32_t hi, bool wrap, uint8_t* mask) noexcept {
+            const __m256i below_lo = _mm256_set1_epi32(static_cast<int>(lo) - 1);
+            const __m256i above_hi = _mm256_set1_epi32(static_cast<int>(hi) + 1);
+            size_t i = 0;
+            for (; i + 8 <= n; i += 8) {
+                __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+                __m256i above = _mm256_cmpgt_epi32(x, below_lo);
+                __m256i below = _mm256_cmpgt_epi32(above_hi, x);
+                __m256i in = wrap ? _mm256_or_si256(above, below) : _mm256_and_si256(above, below);
+                mask[i / 8] = static_cast<uint8_t>(_mm256_movemask_ps(_mm256_castsi256_ps(in)));
+            }
+            RangeScalar(a + i, n - i, lo, hi, wrap, mask + i / 8);
+        }
+#endif
+
+        void Range(uint32_t lo, uint32_t hi, bool wrap, vector<uint8_t>& mask) const {
+            mask.resize((secs.size() + 7) / 8);
+#ifdef TIME_COLUMN_AVX2
+            if (simd) {
+                RangeAvx2(secs.data(), secs.size(), lo, hi, wrap, mask.data());
+                return;
+            }
+#endif
+            RangeScalar(secs.data(), secs.size(), lo, hi, wrap, mask.data());
+        }
+
+        void Difference(const uint32_t* b, size_t b_step, TimeColumn& out) const {
+            out.secs.resize(secs.size());
+#ifdef TIME_COLUMN_AVX2
+            if (simd) {
+                DifferenceAvx2(secs.data(), b, b_step, out.secs.data(), secs.size());
+                return;
+            }
+#endif
+            DifferenceScalar(secs.data(), b, b_step, out.secs.data(), secs.size());
+        }
+
+    public:
+        // allow_simd = false принудительно выбирает скалярные ядра (для сравнения).
+        explicit TimeColumn(bool allow_simd = true) : simd(allow_simd && CpuHasAvx2()) {}
+
+        bool Vectorized() const noexcept {
+            return simd;
+        }
+
+        size_t Size() const noexcept {
+            return secs.size();
+        }
+
+        void Reserve(size_t n) {
+            secs.reserve(n);
+        }
+
+        void Clear() noexcept {
+            secs.clear();
+        }
+
+        const uint32_t* Data() const noexcept {
+            return secs.data();
+        }
+
+        template <class Policy>
+        void Add(const BasicTime<Policy>& t) {
+            secs.push_back(static_cast<uint32_t>(t.ToSeconds()));
+        }
+
+        BasicTime<SilentPolicy> At(size_t i) const {
+            return BasicTime<SilentPolicy>::FromSeconds(static_cast<int>(secs.at(i)));
+        }
+
+        // Нормализация: добавляет n произвольных сумм секунд, приведённых
+        // к времени суток так же, как это делает Time (отрицательные -
+        // назад от полуночи).
+        void AppendSeconds(const int* totals, size_t n) {
+            size_t start = secs.size();
+            secs.resize(start + n);
+#ifdef TIME_COLUMN_AVX2
+            if (simd) {
+                WrapAvx2(totals, secs.data() + start, n);
+                return;
+            }
+#endif
+            WrapScalar(totals, secs.data() + start, n);
+        }
+
+        // Значения уже нормализованы, так что это копирование со скоростью memcpy.
+        void ToSeconds(vector<int>& out) const {
+            out.resize(secs.size());
+            if (!secs.empty()) {
+                memcpy(out.data(), secs.data(), secs.size() * sizeof(uint32_t));
+            }
+        }
+
+        // out[i] = (*this)[i] - other по модулю суток, как Time::operator-;
+        // out может совпадать с *this.
+        template <class Policy>
+        void Difference(const BasicTime<Policy>& other, TimeColumn& out) const {
+            uint32_t value = static_cast<uint32_t>(other.ToSeconds());
+            Difference(&value, 0, out);
+        }
+
+        void Difference(const TimeColumn& other, TimeColumn& out) const {
+            if (other.secs.size() != secs.size()) {
+                throw invalid_argument("Columns must have the same size.");
+            }
+            Difference(other.secs.data(), 1, out);
+        }
+
+        template <class Policy>
+        void Equal(const BasicTime<Policy>& value, vector<uint8_t>& mask) const {
+            uint32_t v = static_cast<uint32_t>(value.ToSeconds());
+            Range(v, v, false, mask);
+        }
+
+        // Включительно с обеих сторон; если from позже to, диапазон
+        // проходит через полночь.
+        template <class Policy>
+        void InRange(const BasicTime<Policy>& from, const BasicTime<Policy>& to, vector<uint8_t>& mask) const {
+            uint32_t lo = static_cast<uint32_t>(from.ToSeconds());
+            uint32_t hi = static_cast<uint32_t>(to.ToSeconds());
+            Range(lo, hi, lo > hi, mask);
+        }
+
+        static size_t CountSet(const vector<uint8_t>& mask) noexcept {
+            size_t count = 0;
+            for (uint8_t bits : mask) {
+                count += static_cast<size_t>(popcount(bits));
+            }
+            return count;
+        }
+};
@@ -0,0 +1,228 @@
+#pragma once
+
+#include <array>
+#include <cerrno>
+#include <charconv>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+using namespace std;
+
+// Форматирование времени суток в буфер вызывающего, без потоков и выделений
+// памяти. Время передаётся секундами от полуночи (0..86399), как хранит Time.
+
+constexpr size_t time24_length = 8;   // "HH:MM:SS"
+constexpr size_t time12_length = 11;  // "HH:MM:SS AM"
+
+// "00", "01", ..., "99" подряд: две цифры числа копируются одним обращением.
+constexpr array<char, 200> MakeDigitPairs() {
+    array<char, 200> pairs{};
+    for (int i = 0; i < 100; ++i) {
+        pairs[2 * i] = static_cast<char>('0' + i / 10);
+        pairs[2 * i + 1] = static_cast<char>('0' + i % 10);
+    }
+    return pairs;
+}
+
+inline constexpr array<char, 200> time_digit_pairs = MakeDigitPairs();
+
+inline char* WriteTwoDigits(unsigned value, char* out) noexcept {
+    memcpy(out, &time_digit_pairs[2 * value], 2);
+    return out + 2;
+}
+
+inline char* WriteClock(unsigned h, unsigned m, unsigned s, char* out) noexcept {
+    out = WriteTwoDigits(h, out);
+    *out++ = ':';
+    out = WriteTwoDigits(m, out);
+    *out++ = ':';
+    return WriteTwoDigits(s, out);
+}
+
+// Пишет "HH:MM:SS", возвращает указатель за последним символом.
+inline char* FormatTime24(uint32_t secs, char* out) noexcept {
+    return WriteClock(secs / 3600, secs / 60 % 60, secs % 60, out);
+}
+
+// Пишет "HH:MM:SS AM" с часами 12, 01, ..., 11.
+inline char* FormatTime12(uint32_t secs, char* out) noexcept {
+    unsigned h = secs / 3600;
+    unsigned h12 = h % 12;
+    out = WriteClock(h12 == 0 ? 12 : h12, secs / 60 % 60, secs % 60, out);
+    memcpy(out, h < 12 ? " AM" : " PM", 3);
+    return out + 3;
+}
+
+// Число до 99 без ведущего нуля: две цифры копируются всегда, а указатель
+// сдвигается на одну или две - без ветвления по длине.
+inline char* WriteShort(unsigned value, char* out) noexcept {
+    unsigned one_digit = value < 10;
+    memcpy(out, &time_digit_pairs[2 * value + one_digit], 2);
+    return out + 2 - one_digit;
+}
+
+// "h:m:s" без ведущих нулей для времени суток, как печатает Time::Print.
+// Пишет до 9 байт, из них последний может оказаться лишним.
+inline char* FormatTimeShort(uint32_t secs, char* out) noexcept {
+    out = WriteShort(secs / 3600, out);
+    *out++ = ':';
+    out = WriteShort(secs / 60 % 60, out);
+    *out++ = ':';
+    return WriteShort(secs % 60, out);
+}
+
+// Тот же вид для произвольных полей. Буферу хватает 36 символов при любых int.
+inline char* FormatFields(int h, int m, int s, char* out) noexcept {
+    out = to_chars(out, out + 11, h).ptr;
+    *out++ = ':';
+    out = to_chars(out, out + 11, m).ptr;
+    *out++ = ':';
+    return to_chars(out, out + 11, s).ptr;
+}
+
+// Готовый текст Watch для всех 86400 времён суток в обоих форматах - "h:m:s"
+// и "h:m:s AM" без ведущих нулей, как печатает Watch::ShowTime. Записи
+// фиксированной длины, показ - одно индексированное копирование без
+// выделений. Таблица (около 2 МБ) строится при первом обращении, один раз
+// на процесс.
+class WatchTextTable {
+    public:
+        static constexpr size_t slot = 12;  // до 11 символов и длина
+
+    private:
+        static constexpr uint32_t seconds_per_day = 24 * 3600;
+
+        struct Entry {
+            char text[slot - 1];
+            uint8_t length;
+        };
+
+        vector<Entry> entries;  // сначала 12-часовой формат, затем 24-часовой
+
+        WatchTextTable() : entries(2 * seconds_per_day) {
+            for (uint32_t s = 0; s < seconds_per_day; ++s) {
+                int h = static_cast<int>(s / 3600);
+                int h12 = h % 12 == 0 ? 12 : h % 12;
+                Entry& e12 = entries[s];
+                char* end = FormatFields(h12, s / 60 % 60, s % 60, e12.text);
+                memcpy(end, h < 12 ? " AM" : " PM", 3);
+                e12.length = static_cast<uint8_t>(end + 3 - e12.text);
+                Entry& e24 = entries[seconds_per_day + s];
+                e24.length = static_cast<uint8_t>(FormatFields(h, s / 60 % 60, s % 60, e24.text) - e24.text);
+            }
+        }
+
+    public:
+        WatchTextTable(const WatchTextTable&) = delete;
+        WatchTextTable& operator=(const WatchTextTable&) = delete;
+
+        static const WatchTextTable& Get() {
+            static const WatchTextTable table;
+            return table;
+        }
+
+        // Копирует запись целиком (в out должно быть slot байт), возвращает
+        // указатель за концом текста.
+        char* Render(uint32_t secs, bool format24, char* out) const noexcept {
+            const Entry& entry = entries[(format24 ? seconds_per_day : 0) + secs];
+            memcpy(out, &entry, slot);
+            return out + entry.length;
+        }
+};
+
+// Пакетный вывод: строки копятся в буфере и уходят в файловый дескриптор
+// одним write(). Add сбрасывает буфер, когда он дорастает до flush_at;
+// AddColumn форматирует весь столбец и отправляет его одним вызовом.
+// Запись идёт мимо буфера cout, поэтому перед смешанным выводом cout нужно
+// сбросить. В Windows вместо write используется _write того же дескриптора.
+class TimeWriter {
+    private:
+        int fd;
+        bool format24;
+        size_t flush_at;
+        string buffer;
+
+        size_t LineLength() const noexcept {
+            return (format24 ? time24_length : time12_length) + 1;
+        }
+
+        // Возвращает число записанных байт или -1, как write.
+        static long long WriteSome(int fd, const char* data, size_t size) noexcept {
+#ifdef _WIN32
+            return _write(fd, data, static_cast<unsigned>(size < INT_MAX ? size : INT_MAX));
+#else
+            return ::write(fd, data, size);
+#endif
+        }
+
+        char* FormatLine(uint32_t secs, char* out) const noexcept {
+            out = format24 ? FormatTime24(secs, out) : FormatTime12(secs, out);
+            *out = '\n';
+            return out + 1;
+        }
+
+    public:
+        explicit TimeWriter(int fd = 1, bool format24 = true, size_t flush_at = 1 << 20)
+            : fd(fd), format24(format24), flush_at(flush_at) {}
+
+        ~TimeWriter() {
+            try {
+                Flush();
+            } catch (...) {
+            }
+        }
+
+        TimeWriter(const TimeWriter&) = delete;
+        TimeWriter& operator=(const TimeWriter&) = delete;
+
+        void Add(uint32_t secs) {
+            size_t used = buffer.size();
+            buffer.resize(used + LineLength());
+            FormatLine(secs, &buffer[used]);
+            if (buffer.size() >= flush_at) {
+                Flush();
+            }
+        }
+
+        void AddColumn(const uint32_t* secs, size_t n) {
+            size_t used = buffer.size();
+            buffer.resize(used + n * LineLength());
+            char* out = &buffer[used];
+            for (size_t i = 0; i < n; ++i) {
+                out = FormatLine(secs[i], out);
+            }
+            Flush();
+        }
+
+        void Flush() {
+            size_t done = 0;
+            while (done < buffer.size()) {
+                long long n = WriteSome(fd, buffer.data() + done, buffer.size() - done);
+                if (n < 0 && errno == EINTR) {
+                    continue;
+                }
+                // Запись нуля байт из непустого буфера - тоже ошибка: повтор
+                // ничего не изменит, а цикл крутился бы вечно.
+                if (n <= 0) {
+                    buffer.erase(0, done);
+                    throw runtime_error("TimeWriter: write failed");
+                }
+                done += static_cast<size_t>(n);
+            }
+            buffer.clear();
+        }
+
+        size_t Pending() const noexcept {
+            return buffer.size();
+        }
+};
@@ -0,0 +1,337 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "time.hpp"
+#include "time_column.hpp"
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Строка, которую не удалось разобрать. line - номер строки с единицы,
+// offset - смещение её начала в файле, reason - статическая строка.
+struct TimeParseError {
+    size_t line;
+    size_t offset;
+    const char* reason;
+};
+
+struct TimeParseResult {
+    size_t parsed = 0;
+    size_t bad_lines = 0;
+    // Первые max_errors ошибок по порядку строк; остальные только в bad_lines.
+    vector<TimeParseError> errors;
+};
+
+// Массовая загрузка времён вида HH:MM:SS, по одному на строку, сразу в
+// TimeColumn. Правила те же, что у конструктора Time: поля - неотрицательные
+// int, значения больше 59 или 23 нормализуются. Пустые строки пропускаются,
+// "\r\n" допускается. Ошибки собираются в результат, исключения бросаются
+// только если файл не удалось открыть.
+//
+// Строки ровно из восьми символов разбираются за одно 64-битное чтение:
+// проверка цифр и двоеточий и перевод в число делаются над всеми байтами
+// сразу (SWAR, на little-endian машинах); остальные идут через
+// посимвольный разбор.
+class TimeParser {
+    private:
+        static constexpr long long seconds_per_day = 24 * 3600;
+
+        static constexpr uint64_t colon_mask = 0x0000FF0000FF0000ULL;
+        static constexpr uint64_t colons = 0x00003A00003A0000ULL;
+        static constexpr uint64_t zeros = 0x3030303030303030ULL;
+        static constexpr uint64_t high_nibbles = 0xF0F0F0F0F0F0F0F0ULL;
+        static constexpr uint64_t sixes = 0x0606060606060606ULL;
+
+        struct Chunk {
+            const char* begin;
+            const char* end;
+            vector<uint32_t> secs;
+            vector<TimeParseError> errors;
+            size_t parsed = 0;
+            size_t bad_lines = 0;
+            size_t lines = 0;
+            exception_ptr failure;
+        };
+
+        // Потоки присоединяются и при исключении в вызывающем потоке:
+        // разрушение присоединяемого std::thread вызвало бы terminate.
+        struct JoinGuard {
+            vector<thread>& workers;
+
+            ~JoinGuard() {
+                for (thread& worker : workers) {
+                    if (worker.joinable()) {
+                        worker.join();
+                    }
+                }
+            }
+        };
+
+        static uint32_t Wrap(long long total) noexcept {
+            return static_cast<uint32_t>(total - FloorDiv<seconds_per_day>(total) * seconds_per_day);
+        }
+
+        // Цифра - байт 0x30..0x39: старший полубайт 3, и прибавление 6 его
+        // не меняет. Байт вне этого диапазона проваливает проверку сам, а
+        // перенос из него в соседний байт уже ничего не решает.
+        // Маски рассчитаны на little-endian чтение (первый символ - младший
+        // байт); на big-endian строка уходит в посимвольный разбор.
+        static bool ParseFixed(const char* p, uint32_t& out) noexcept {
+            if constexpr (endian::native != endian::little) {
+                return false;
+            }
+            uint64_t word;
+            memcpy(&word, p, sizeof(word));
+            const uint64_t digit_mask = ~colon_mask;
+            if ((word & colon_mask) != colons ||
+                (word & digit_mask & high_nibbles) != (zeros & digit_mask) ||
+                ((word + sixes) & digit_mask & high_nibbles) != (zeros & digit_mask)) {
+                return false;
+            }
+            // Байт i становится 10 * d[i] + d[i + 1]: часы в байте 0,
+            // минуты в байте 3, секунды в байте 6. Переносов между байтами нет.
+            uint64_t digits = word - zeros;
+            uint64_t pairs = digits * 10 + (digits >> 8);
+            long long h = static_cast<long long>(pairs & 0xFF);
+            long long m = static_cast<long long>((pairs >> 24) & 0xFF);
+            long long s = static_cast<long long>((pairs >> 48) & 0xFF);
+            out = Wrap(h * 3600 + m * 60 + s);
+            return true;
+        }
+
+        static const char* ParseField(const char*& p, const char* end, long long& value) noexcept {
+            if (p < end && *p == '-') {
+                return "negative value";
+            }
+            const char* start = p;
+            value = 0;
+            while (p < end && *p >= '0' && *p <= '9') {
+                value = value * 10 + (*p - '0');
+                if (value > INT32_MAX) {
+                    return "value out of range";
+                }
+                ++p;
+            }
+            return p == start ? "expected HH:MM:SS" : nullptr;
+        }
+
+        // Строка без '\n'; возвращает причину ошибки или nullptr.
+        static const char* ParseVariable(const char* p, const char* end, uint32_t& out) noexcept {
+            while (end > p && (end[-1] == '\r' || end[-1] == ' ' || end[-1] == '\t')) {
+                --end;
+            }
+            while (p < end && (*p == ' ' || *p == '\t')) {
+                ++p;
+            }
+            long long fields[3];
+            for (int i = 0; i < 3; ++i) {
+                if (const char* reason = ParseField(p, end, fields[i])) {
+                    return reason;
+                }
+                if (i < 2) {
+                    if (p == end || *p != ':') {
+                        return "expected HH:MM:SS";
+                    }
+                    ++p;
+                }
+            }
+            if (p != end) {
+                return "expected HH:MM:SS";
+            }
+            out = Wrap(fields[0] * 3600 + fields[1] * 60 + fields[2]);
+            return nullptr;
+        }
+
+        // Значения дописываются в secs: при одном потоке это сразу столбец.
+        static void ParseChunk(Chunk& chunk, vector<uint32_t>& secs, const char* file_begin, size_t max_errors) {
+            const char* p = chunk.begin;
+            const char* end = chunk.end;
+            secs.reserve(secs.size() + static_cast<size_t>(end - p) / 9 + 1);
+            while (p < end) {
+                ++chunk.lines;
+                uint32_t value;
+                if (end - p >= 8 && ParseFixed(p, value)) {
+                    const char* q = p + 8;
+                    if (q < end && *q == '\r') {
+                        ++q;
+                    }
+                    if (q == end || *q == '\n') {
+                        secs.push_back(value);
+                        p = q == end ? end : q + 1;
+                        continue;
+                    }
+                }
+                const char* newline = static_cast<const char*>(memchr(p, '\n', static_cast<size_t>(end - p)));
+                const char* line_end = newline ? newline : end;
+                bool blank = true;
+                for (const char* c = p; c < line_end; ++c) {
+                    if (*c != ' ' && *c != '\t' && *c != '\r') {
+                        blank = false;
+                        break;
+                    }
+                }
+                if (!blank) {
+                    if (const char* reason = ParseVariable(p, line_end, value)) {
+                        ++chunk.bad_lines;
+                        if (chunk.errors.size() < max_errors) {
+                            chunk.errors.push_back(TimeParseError{chunk.lines, static_cast<size_t>(p - file_begin), reason});
+                        }
+                    } else {
+                        secs.push_back(value);
+                    }
+                }
+                p = newline ? newline + 1 : end;
+            }
+        }
+
+#ifdef __linux__
+        // Отображение файла в память на время разбора.
+        class MappedFile {
+            private:
+                int fd;
+                void* address;
+                size_t length;
+
+            public:
+                explicit MappedFile(const string& path) : fd(-1), address(nullptr), length(0) {
+                    fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+                    if (fd < 0) {
+                        throw runtime_error("Cannot open " + path);
+                    }
+                    struct stat info;
+                    if (fstat(fd, &info) != 0) {
+                        close(fd);
+                        throw runtime_error("Cannot stat " + path);
+                    }
+                    length = static_cast<size_t>(info.st_size);
+                    if (length == 0) {
+                        return;
+                    }
+                    address = mmap(nullptr, length, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+                    if (address == MAP_FAILED) {
+                        close(fd);
+                        throw runtime_error("Cannot map " + path);
+                    }
+                }
+
+                ~MappedFile() {
+                    if (address) {
+                        munmap(address, length);
+                    }
+                    close(fd);
+                }
+
+                MappedFile(const MappedFile&) = delete;
+                MappedFile& operator=(const MappedFile&) = delete;
+
+                const char* Data() const noexcept {
+                    return static_cast<const char*>(address);
+                }
+
+                size_t Size() const noexcept {
+                    return length;
+                }
+        };
+#endif
+
+    public:
+        // Разбирает буфер и добавляет времена в конец out. threads > 1 делит
+        // буфер на столько частей по границам строк; порядок значений и
+        // номера строк в ошибках такие же, как при разборе в одном потоке.
+        static TimeParseResult Parse(const char* data, size_t size, TimeColumn& out, int threads = 1, size_t max_errors = 1000) {
+            if (threads < 1) {
+                threads = 1;
+            }
+            vector<Chunk> chunks(static_cast<size_t>(threads));
+            const char* end = data + size;
+            const char* begin = data;
+            for (int i = 0; i < threads; ++i) {
+                const char* split = i + 1 == threads ? end : data + size * (i + 1) / threads;
+                if (split < begin) {
+                    split = begin;
+                }
+                if (split < end && split > data && split[-1] != '\n') {
+                    const char* newline = static_cast<const char*>(memchr(split, '\n', static_cast<size_t>(end - split)));
+                    split = newline ? newline + 1 : end;
+                }
+                chunks[i].begin = begin;
+                chunks[i].end = split;
+                begin = split;
+            }
+
+            // Первая часть разбирается прямо в столбец, остальные - в свои
+            // буферы, которые потом дописываются по порядку.
+            size_t start = out.secs.size();
+            vector<thread> workers;
+            workers.reserve(static_cast<size_t>(threads - 1));
+            {
+                JoinGuard guard{workers};
+                for (int i = 1; i < threads; ++i) {
+                    workers.emplace_back([&chunks, data, max_errors, i] {
+                        try {
+                            ParseChunk(chunks[i], chunks[i].secs, data, max_errors);
+                        } catch (...) {
+                            chunks[i].failure = current_exception();
+                        }
+                    });
+                }
+                ParseChunk(chunks[0], out.secs, data, max_errors);
+            }
+            chunks[0].parsed = out.secs.size() - start;
+            size_t total = out.secs.size();
+            for (int i = 1; i < threads; ++i) {
+                if (chunks[i].failure) {
+                    rethrow_exception(chunks[i].failure);
+                }
+                chunks[i].parsed = chunks[i].secs.size();
+                total += chunks[i].parsed;
+            }
+
+            TimeParseResult result;
+            out.secs.reserve(total);
+            size_t first_line = 0;
+            for (const Chunk& chunk : chunks) {
+                out.secs.insert(out.secs.end(), chunk.secs.begin(), chunk.secs.end());
+                result.parsed += chunk.parsed;
+                result.bad_lines += chunk.bad_lines;
+                for (const TimeParseError& error : chunk.errors) {
+                    if (result.errors.size() < max_errors) {
+                        result.errors.push_back(TimeParseError{first_line + error.line, error.offset, error.reason});
+                    }
+                }
+                first_line += chunk.lines;
+            }
+            return result;
+        }
+
+        // То же для файла: на Linux он отображается в память, иначе читается целиком.
+        static TimeParseResult ParseFile(const string& path, TimeColumn& out, int threads = 1, size_t max_errors = 1000) {
+#ifdef __linux__
+            MappedFile file(path);
+            return Parse(file.Data(), file.Size(), out, threads, max_errors);
+#else
+            ifstream file(path, ios::binary);
+            if (!file) {
+                throw runtime_error("Cannot open " + path);
+            }
+            stringstream text;
+            text << file.rdbuf();
+            string data = text.str();
+            return Parse(data.data(), data.size(), out, threads, max_errors);
+#endif
+        }
+};
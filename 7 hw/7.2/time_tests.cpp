@@ -0,0 +1,365 @@
+#include <gtest/gtest.h>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+#include "time.hpp"
+#include "time_column.hpp"
+#include "time_parser.hpp"
+#include "time_format.hpp"
+#include "clock_fleet.hpp"
+
+// упакованное время: одно число секунд, разность по модулю суток
+TEST(TimeTest, PackedSecondsOfDay) {
+    EXPECT_EQ(sizeof(BasicTime<SilentPolicy>), 4u);
+
+    Time t(23, 59, 59);
+    EXPECT_EQ(t.ToSeconds(), 86399);
+    Time wrapped(47, 120, 3600);
+    EXPECT_EQ(wrapped.Hours(), 2);
+    EXPECT_EQ(wrapped.Minutes(), 0);
+    EXPECT_EQ(wrapped.Seconds(), 0);
+
+    Time early = Time(1, 0, 0) - Time(2, 0, 0);
+    EXPECT_EQ(early.Hours(), 23);
+    Time late = Time(0, 0, 0) - Time(0, 0, 1);
+    EXPECT_EQ(late.ToSeconds(), 86399);
+
+    SimpleWatch watch;
+    watch.SetTime(t, 25, 0, 1);
+    EXPECT_EQ(t.Hours(), 1);
+    EXPECT_EQ(t.Seconds(), 1);
+    EXPECT_THROW(Time(0, -1, 0), invalid_argument);
+}
+
+// литерал и арифметика в constexpr: ошибка здесь - ошибка сборки
+static_assert("10:20:30"_t.ToSeconds() == 37230);
+static_assert("9:05:07"_t == BasicTime<SilentPolicy>(9, 5, 7));
+static_assert(("00:00:00"_t - "00:00:01"_t).ToSeconds() == 86399);
+static_assert(BasicTime<SilentPolicy>::FromSeconds(90061).Hours() == 1);
+static_assert([] {
+    auto t = "23:59:59"_t;
+    t -= "12:00:00"_t;
+    return t.Hours() == 11 && t.Minutes() == 59 && t.Seconds() == 59;
+}());
+
+TEST(TimeTest, LiteralConvertsToCountedTime) {
+    Time t = "07:08:09"_t;
+    EXPECT_EQ(t.Hours(), 7);
+    EXPECT_EQ(t.Minutes(), 8);
+    EXPECT_EQ(t.Seconds(), 9);
+    EXPECT_EQ(Time::GetCount(), 1);
+}
+
+static uint32_t WrapReference(long long total) {
+    return static_cast<uint32_t>((total % 86400 + 86400) % 86400);
+}
+
+static vector<int> ColumnInputs(size_t n) {
+    vector<int> totals = {INT_MIN, INT_MIN + 1, -86401, -86400, -86399, -1, 0, 1, 86399, 86400, 86401, INT_MAX - 1, INT_MAX};
+    mt19937 random(46);
+    uniform_int_distribution<int> any(INT_MIN, INT_MAX);
+    uniform_int_distribution<int> near(-3 * 86400, 3 * 86400);
+    while (totals.size() < n) {
+        totals.push_back(totals.size() % 2 ? any(random) : near(random));
+    }
+    return totals;
+}
+
+// Размеры не кратны 8, чтобы захватить и скалярный хвост векторных ядер.
+TEST(TimeColumnTests, AppendSecondsMatchesScalarAndReference) {
+    vector<int> totals = ColumnInputs(2000003);
+    TimeColumn simd, scalar(false);
+    simd.AppendSeconds(totals.data(), totals.size());
+    scalar.AppendSeconds(totals.data(), totals.size());
+    ASSERT_EQ(simd.Size(), totals.size());
+    for (size_t i = 0; i < totals.size(); ++i) {
+        ASSERT_EQ(simd.Data()[i], WrapReference(totals[i])) << totals[i];
+        ASSERT_EQ(scalar.Data()[i], simd.Data()[i]) << totals[i];
+    }
+
+    vector<int> back;
+    simd.ToSeconds(back);
+    EXPECT_EQ(back[6], 0);
+    EXPECT_EQ(back[4], 1);
+    EXPECT_EQ(simd.At(5).ToSeconds(), 86399);
+}
+
+TEST(TimeColumnTests, DifferenceMasksAndCounts) {
+    vector<int> a_totals = ColumnInputs(1003), b_totals = ColumnInputs(2006);
+    b_totals.erase(b_totals.begin(), b_totals.begin() + 1003);
+    TimeColumn a, b, a_scalar(false), b_scalar(false);
+    a.AppendSeconds(a_totals.data(), a_totals.size());
+    b.AppendSeconds(b_totals.data(), b_totals.size());
+    a_scalar.AppendSeconds(a_totals.data(), a_totals.size());
+    b_scalar.AppendSeconds(b_totals.data(), b_totals.size());
+
+    TimeColumn diff, diff_scalar(false), shifted, shifted_scalar(false);
+    a.Difference(b, diff);
+    a_scalar.Difference(b_scalar, diff_scalar);
+    BasicTime<SilentPolicy> noon(12, 0, 0);
+    a.Difference(noon, shifted);
+    a_scalar.Difference(noon, shifted_scalar);
+    for (size_t i = 0; i < a.Size(); ++i) {
+        long long expected = static_cast<long long>(a.Data()[i]) - b.Data()[i];
+        ASSERT_EQ(diff.Data()[i], WrapReference(expected));
+        ASSERT_EQ(diff_scalar.Data()[i], diff.Data()[i]);
+        ASSERT_EQ(shifted.Data()[i], WrapReference(a.Data()[i] - 43200LL));
+        ASSERT_EQ(shifted_scalar.Data()[i], shifted.Data()[i]);
+        ASSERT_TRUE(a.At(i) - b.At(i) == diff.At(i));
+    }
+    EXPECT_THROW(a.Difference(TimeColumn(), diff), invalid_argument);
+
+    BasicTime<SilentPolicy> from(22, 0, 0), to(2, 0, 0), midnight(0, 0, 0);
+    vector<uint8_t> in_day, in_night, at_midnight, mask_scalar;
+    a.InRange(to, from, in_day);
+    a.InRange(from, to, in_night);
+    a.Equal(midnight, at_midnight);
+    size_t day = 0, night = 0, zero = 0;
+    for (size_t i = 0; i < a.Size(); ++i) {
+        uint32_t v = a.Data()[i];
+        bool expect_day = v >= 7200 && v <= 79200;
+        bool expect_night = v >= 79200 || v <= 7200;
+        ASSERT_EQ((in_day[i / 8] >> (i % 8)) & 1, expect_day ? 1 : 0) << v;
+        ASSERT_EQ((in_night[i / 8] >> (i % 8)) & 1, expect_night ? 1 : 0) << v;
+        ASSERT_EQ((at_midnight[i / 8] >> (i % 8)) & 1, v == 0 ? 1 : 0) << v;
+        day += expect_day;
+        night += expect_night;
+        zero += v == 0;
+    }
+    EXPECT_EQ(TimeColumn::CountSet(in_day), day);
+    EXPECT_EQ(TimeColumn::CountSet(in_night), night);
+    EXPECT_EQ(TimeColumn::CountSet(at_midnight), zero);
+
+    a_scalar.InRange(to, from, mask_scalar);
+    EXPECT_EQ(mask_scalar, in_day);
+    a_scalar.InRange(from, to, mask_scalar);
+    EXPECT_EQ(mask_scalar, in_night);
+    a_scalar.Equal(midnight, mask_scalar);
+    EXPECT_EQ(mask_scalar, at_midnight);
+}
+
+// строки ровно из восьми символов идут через SWAR, остальные - посимвольно
+TEST(TimeParserTests, FixedAndVariableLines) {
+    string text = "12:34:56\n"
+                  "99:99:99\r\n"
+                  "\n"
+                  "   \t\r\n"
+                  "1:2:3\n"
+                  " 07:08:09 \n"
+                  "12:3a:56\n"
+                  "-1:00:00\n"
+                  "99999999999:0:0\n"
+                  "12:34\n"
+                  "00:00:00";
+    TimeColumn column;
+    TimeParseResult result = TimeParser::Parse(text.data(), text.size(), column);
+    ASSERT_EQ(result.parsed, 5u);
+    ASSERT_EQ(column.Size(), 5u);
+    EXPECT_EQ(column.Data()[0], 12u * 3600 + 34 * 60 + 56);
+    EXPECT_EQ(column.Data()[1], (99u * 3600 + 99 * 60 + 99) % 86400);
+    EXPECT_EQ(column.Data()[2], 3723u);
+    EXPECT_EQ(column.Data()[3], 7u * 3600 + 8 * 60 + 9);
+    EXPECT_EQ(column.Data()[4], 0u);
+
+    EXPECT_EQ(result.bad_lines, 4u);
+    ASSERT_EQ(result.errors.size(), 4u);
+    size_t lines[] = {7, 8, 9, 10};
+    for (size_t i = 0; i < 4; ++i) {
+        EXPECT_EQ(result.errors[i].line, lines[i]);
+    }
+    EXPECT_EQ(result.errors[0].offset, text.find("12:3a"));
+    EXPECT_STREQ(result.errors[1].reason, "negative value");
+    EXPECT_STREQ(result.errors[2].reason, "value out of range");
+}
+
+// при любом числе потоков значения, номера строк и усечение ошибок те же
+TEST(TimeParserTests, ThreadSplitKeepsOrderAndLineNumbers) {
+    string text;
+    mt19937 random(47);
+    for (int i = 0; i < 5000; ++i) {
+        int kind = static_cast<int>(random() % 20);
+        if (kind == 0) {
+            text += "bad line\n";
+        } else if (kind == 1) {
+            text += "\r\n";
+        } else if (kind == 2) {
+            text += to_string(random() % 30) + ":" + to_string(random() % 70) + ":" + to_string(random() % 70) + "\r\n";
+        } else {
+            char line[16];
+            snprintf(line, sizeof(line), "%02u:%02u:%02u\n", static_cast<unsigned>(random() % 24),
+                     static_cast<unsigned>(random() % 60), static_cast<unsigned>(random() % 60));
+            text += line;
+        }
+    }
+
+    TimeColumn single;
+    TimeParseResult expected = TimeParser::Parse(text.data(), text.size(), single);
+    ASSERT_GT(expected.bad_lines, 10u);
+    for (int threads = 2; threads <= 5; ++threads) {
+        TimeColumn column;
+        TimeParseResult result = TimeParser::Parse(text.data(), text.size(), column, threads);
+        ASSERT_EQ(result.parsed, expected.parsed);
+        ASSERT_EQ(result.bad_lines, expected.bad_lines);
+        ASSERT_EQ(column.Size(), single.Size());
+        for (size_t i = 0; i < column.Size(); ++i) {
+            ASSERT_EQ(column.Data()[i], single.Data()[i]);
+        }
+        ASSERT_EQ(result.errors.size(), expected.errors.size());
+        for (size_t i = 0; i < result.errors.size(); ++i) {
+            EXPECT_EQ(result.errors[i].line, expected.errors[i].line);
+            EXPECT_EQ(result.errors[i].offset, expected.errors[i].offset);
+        }
+
+        TimeColumn limited;
+        TimeParseResult truncated = TimeParser::Parse(text.data(), text.size(), limited, threads, 3);
+        EXPECT_EQ(truncated.bad_lines, expected.bad_lines);
+        ASSERT_EQ(truncated.errors.size(), 3u);
+        for (size_t i = 0; i < 3; ++i) {
+            EXPECT_EQ(truncated.errors[i].line, expected.errors[i].line);
+        }
+    }
+}
+
+TEST(TimeParserTests, ParseFileAppendsToColumn) {
+    string path = (filesystem::temp_directory_path() / "time_parser_test.txt").string();
+    {
+        ofstream file(path, ios::binary);
+        file << "01:02:03\r\n23:59:59\r\n";
+    }
+    TimeColumn column;
+    column.Add(BasicTime<SilentPolicy>(5, 0, 0));
+    TimeParseResult result = TimeParser::ParseFile(path, column, 2);
+    filesystem::remove(path);
+    EXPECT_EQ(result.parsed, 2u);
+    ASSERT_EQ(column.Size(), 3u);
+    EXPECT_EQ(column.Data()[1], 3723u);
+    EXPECT_EQ(column.Data()[2], 86399u);
+    EXPECT_THROW(TimeParser::ParseFile(path, column), runtime_error);
+}
+
+// все 86400 времён суток против snprintf
+TEST(TimeFormatTests, FormattersMatchSnprintf) {
+    char got[40], expected[40];
+    for (uint32_t s = 0; s < 86400; ++s) {
+        unsigned h = s / 3600, m = s / 60 % 60, sec = s % 60;
+        *FormatTime24(s, got) = 0;
+        snprintf(expected, sizeof(expected), "%02u:%02u:%02u", h, m, sec);
+        ASSERT_STREQ(got, expected);
+
+        *FormatTime12(s, got) = 0;
+        snprintf(expected, sizeof(expected), "%02u:%02u:%02u %s", h % 12 == 0 ? 12 : h % 12, m, sec, h < 12 ? "AM" : "PM");
+        ASSERT_STREQ(got, expected);
+
+        *FormatTimeShort(s, got) = 0;
+        snprintf(expected, sizeof(expected), "%u:%u:%u", h, m, sec);
+        ASSERT_STREQ(got, expected);
+    }
+
+    *FormatFields(INT_MIN, INT_MAX, -7, got) = 0;
+    snprintf(expected, sizeof(expected), "%d:%d:%d", INT_MIN, INT_MAX, -7);
+    EXPECT_STREQ(got, expected);
+
+    Time t(13, 5, 9);
+    *t.Format24(got) = 0;
+    EXPECT_STREQ(got, "13:05:09");
+    *t.Format12(got) = 0;
+    EXPECT_STREQ(got, "01:05:09 PM");
+    testing::internal::CaptureStdout();
+    t.Print();
+    EXPECT_EQ(testing::internal::GetCapturedStdout(), "13:5:9\n");
+}
+
+static string ReadAll(FILE* file) {
+    string text;
+    rewind(file);
+    char chunk[256];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        text.append(chunk, n);
+    }
+    return text;
+}
+
+TEST(TimeFormatTests, TimeWriterWritesToItsDescriptor) {
+    FILE* file = tmpfile();
+    ASSERT_NE(file, nullptr);
+    {
+        TimeWriter writer(fileno(file), true, 18);
+        writer.Add(3723);
+        EXPECT_EQ(writer.Pending(), 9u);
+        writer.Add(86399);
+        EXPECT_EQ(writer.Pending(), 0u);
+        writer.Add(0);
+        uint32_t column[] = {43200, 59};
+        writer.AddColumn(column, 2);
+        EXPECT_EQ(writer.Pending(), 0u);
+        writer.Add(1);
+    }
+    EXPECT_EQ(ReadAll(file), "01:02:03\n23:59:59\n00:00:00\n12:00:00\n00:00:59\n00:00:01\n");
+    fclose(file);
+
+    file = tmpfile();
+    ASSERT_NE(file, nullptr);
+    {
+        TimeWriter writer(fileno(file), false);
+        writer.Add(0);
+        writer.Add(13 * 3600);
+    }
+    EXPECT_EQ(ReadAll(file), "12:00:00 AM\n01:00:00 PM\n");
+    fclose(file);
+
+    TimeWriter broken(-1);
+    broken.Add(0);
+    EXPECT_THROW(broken.Flush(), runtime_error);
+    EXPECT_EQ(broken.Pending(), 9u);
+}
+
+// текст из WatchTextTable совпадает с вычисленным для всех времён суток
+TEST(TimeFormatTests, WatchTableMatchesComputedText) {
+    char computed[WatchTextTable::slot], cached[WatchTextTable::slot];
+    for (bool format24 : {true, false}) {
+        Watch plain(format24), table(format24, true);
+        for (int s = 0; s < 86400; ++s) {
+            Time t = BasicTime<SilentPolicy>::FromSeconds(s);
+            string a(computed, plain.Render(t, computed));
+            string b(cached, table.Render(t, cached));
+            ASSERT_EQ(a, b) << s;
+        }
+    }
+    EXPECT_EQ(&WatchTextTable::Get(), &WatchTextTable::Get());
+}
+
+// сдвиг на любое число секунд, включая пределы long long
+TEST(TimeTest, AdvanceWrapsAnyOffset) {
+    long long offsets[] = {1, -1, 86400, -86401, 100000000000000LL, -100000000000000LL, LLONG_MAX, LLONG_MIN};
+    for (long long offset : offsets) {
+        BasicTime<SilentPolicy> t(23, 59, 59);
+        t.Advance(offset);
+        long long expected = ((86399 + offset % 86400) % 86400 + 86400) % 86400;
+        EXPECT_EQ(t.ToSeconds(), expected) << offset;
+        EXPECT_LT(t.Hours(), 24) << offset;
+    }
+}
+
+TEST(ClockFleetTests, AdvanceAllAndRender) {
+    ClockFleet fleet;
+    fleet.Add<CuckooClock>(1, 2, 3);
+    fleet.Add<WallClock>(23, 0, 0);
+    fleet.AdvanceAll(LLONG_MIN);
+    fleet.AdvanceAll(-100000000000000LL);
+    long long shift = (LLONG_MIN % 86400 - 100000000000000LL % 86400) % 86400 + 86400;
+    EXPECT_EQ(fleet.Of<CuckooClock>()[0].time.ToSeconds(), (3723 + shift) % 86400);
+    EXPECT_EQ(fleet.Of<WallClock>()[0].time.ToSeconds(), (82800 + shift) % 86400);
+
+    string text;
+    fleet.RenderAll(text);
+    testing::internal::CaptureStdout();
+    fleet.ForEach([](const auto& clock) { clock.ShowTime(); });
+    EXPECT_EQ(text, testing::internal::GetCapturedStdout());
+    EXPECT_EQ(fleet.Size(), 2u);
+}
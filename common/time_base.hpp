@@ -0,0 +1,160 @@
+#pragma once
+
+// Общая основа Time для всех лабораторных: политики времени жизни, счётчик
+// живых объектов и деление с округлением вниз. Каждая лабораторная
+// подключает этот файл из своего time.h/time.hpp.
+
+#include <atomic>
+#include <cassert>
+#include <iostream>
+#include <mutex>
+using namespace std;
+
+// Политики времени жизни Time, выбираются на этапе компиляции:
+// SilentPolicy - ни счётчика, ни вывода, конструктор и деструктор тривиальные;
+// CountingPolicy - только счётчик живых объектов;
+// TracingPolicy - счётчик и учебный вывод в cout (как было раньше).
+struct SilentPolicy {
+    static constexpr bool counts = false;
+    static constexpr bool traces = false;
+};
+
+struct CountingPolicy {
+    static constexpr bool counts = true;
+    static constexpr bool traces = false;
+};
+
+struct TracingPolicy {
+    static constexpr bool counts = true;
+    static constexpr bool traces = true;
+};
+
+// Политику по умолчанию можно заменить: -DTIME_LIFETIME_POLICY=SilentPolicy
+#ifndef TIME_LIFETIME_POLICY
+#define TIME_LIFETIME_POLICY TracingPolicy
+#endif
+
+// Счётчик живых объектов типа T. У каждого потока свой слот, в который
+// пишет только он сам (обычные load/store без атомарного RMW), а чтение
+// складывает слоты всех потоков. Слот завершившегося потока переносится
+// в общий остаток, так что объекты, пережившие свой поток, не теряются.
+template <class T>
+class LiveCounter {
+    private:
+        struct Slot {
+            atomic<long> value{0};
+            Slot* next = nullptr;
+
+            Slot() {
+                lock_guard<mutex> guard(lock);
+                next = head;
+                head = this;
+            }
+
+            ~Slot() {
+                lock_guard<mutex> guard(lock);
+                retired += value.load(memory_order_relaxed);
+                Slot** link = &head;
+                while (*link != this) {
+                    link = &(*link)->next;
+                }
+                *link = next;
+            }
+        };
+
+        static inline mutex lock;
+        static inline Slot* head = nullptr;
+        static inline long retired = 0;
+
+        static Slot& Local() noexcept {
+            thread_local Slot slot;
+            return slot;
+        }
+
+    public:
+        static void Add(long delta) noexcept {
+            Slot& slot = Local();
+            slot.value.store(slot.value.load(memory_order_relaxed) + delta, memory_order_relaxed);
+        }
+
+        static long Get() noexcept {
+            lock_guard<mutex> guard(lock);
+            long total = retired;
+            for (Slot* slot = head; slot; slot = slot->next) {
+                total += slot->value.load(memory_order_relaxed);
+            }
+            return total;
+        }
+};
+
+// Базовый класс с хуками конструктора и деструктора. Копия тоже считается
+// живым объектом, иначе её деструктор уводил бы счётчик в минус.
+template <class Policy, bool Counts = Policy::counts>
+class TimeLifetime {
+    protected:
+        TimeLifetime() {
+            Constructed();
+        }
+
+        TimeLifetime(const TimeLifetime&) {
+            Constructed();
+        }
+
+        TimeLifetime& operator=(const TimeLifetime&) = default;
+
+        ~TimeLifetime() noexcept {
+            LiveCounter<TimeLifetime>::Add(-1);
+            if (Policy::traces) {
+                cout << "Destructor is called. Current count: " << Count() << endl;
+            }
+        }
+
+        static int Count() noexcept {
+            return static_cast<int>(LiveCounter<TimeLifetime>::Get());
+        }
+
+    private:
+        static void Constructed() {
+            LiveCounter<TimeLifetime>::Add(1);
+            if (Policy::traces) {
+                cout << "Constructor is called. Current count: " << Count() << endl;
+            }
+        }
+};
+
+// Без подсчёта базовый класс пустой, и Time остаётся тривиально разрушаемым.
+template <class Policy>
+class TimeLifetime<Policy, false> {
+    protected:
+        static int Count() noexcept {
+            return 0;
+        }
+};
+
+// Деление с округлением вниз на константу D без команды деления и без
+// ветвлений по знаку: x сдвигается на кратное D в неотрицательную область,
+// а частное берётся из старшей половины 128-битного произведения на
+// ceil(2^64 / D). Сдвиг выбран так, чтобы смещённое x было меньше 2^64 / D.
+// Предусловие: |x| < D * 2^(63 - 2 * BitWidth(D)), только тогда частное
+// точное; для D до 86400 это |x| < D * 2^29 (около 4.6e13), с запасом для
+// сумм из int. Выход за предел ловит assert в отладочной сборке.
+// Компиляторы без __int128 (MSVC) делят обычным / и % без ограничений.
+constexpr int BitWidth(unsigned long long v) noexcept {
+    return v ? 1 + BitWidth(v >> 1) : 0;
+}
+
+template <long long D>
+constexpr long long FloorDiv(long long x) noexcept {
+    static_assert(D > 1 && (D & (D - 1)) != 0, "FloorDiv is for divisors that are not powers of two");
+#ifdef __SIZEOF_INT128__
+    __extension__ typedef unsigned __int128 wide;
+    constexpr int shift = 63 - 2 * BitWidth(D);
+    constexpr unsigned long long offset = 1ULL << shift;
+    constexpr unsigned long long magic = ~0ULL / D + 1;
+    assert(x >= -static_cast<long long>(D * offset) && x < static_cast<long long>(D * offset));
+    unsigned long long biased = static_cast<unsigned long long>(x) + D * offset;
+    return static_cast<long long>((static_cast<wide>(biased) * magic) >> 64) - static_cast<long long>(offset);
+#else
+    return x / D - (x % D < 0);
+#endif
+}
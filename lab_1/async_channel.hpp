@@ -0,0 +1,247 @@
+#pragma once
+
+#include <coroutine>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "ring_buffer.hpp"
+#include "latency_trace.hpp"
+
+class Executor {
+public:
+    virtual ~Executor() {}
+    virtual void post(std::coroutine_handle<> handle) = 0;
+};
+
+class InlineExecutor : public Executor {
+private:
+    std::deque<std::coroutine_handle<>> ready;
+
+public:
+    void post(std::coroutine_handle<> handle) override {
+        ready.push_back(handle);
+    }
+
+    void run() {
+        while (!ready.empty()) {
+            std::coroutine_handle<> handle = ready.front();
+            ready.pop_front();
+            handle.resume();
+        }
+    }
+};
+
+class ThreadPoolExecutor : public Executor {
+private:
+    std::vector<std::thread> workers;
+    std::deque<std::coroutine_handle<>> ready;
+    std::mutex lock;
+    std::condition_variable cv;
+    bool stopping;
+
+    void work() {
+        while (true) {
+            std::coroutine_handle<> handle;
+            {
+                std::unique_lock<std::mutex> guard(lock);
+                cv.wait(guard, [this] { return stopping || !ready.empty(); });
+                if (ready.empty()) return;
+                handle = ready.front();
+                ready.pop_front();
+            }
+            handle.resume();
+        }
+    }
+
+public:
+    explicit ThreadPoolExecutor(int threads) : stopping(false) {
+        if (threads < 1) throw std::invalid_argument("Thread count must be positive");
+        for (int i = 0; i < threads; ++i) {
+            workers.emplace_back([this] { work(); });
+        }
+    }
+
+    ~ThreadPoolExecutor() {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            stopping = true;
+        }
+        cv.notify_all();
+        for (std::thread &worker : workers) {
+            worker.join();
+        }
+    }
+
+    void post(std::coroutine_handle<> handle) override {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            ready.push_back(handle);
+        }
+        cv.notify_one();
+    }
+};
+
+class Task {
+public:
+    struct promise_type {
+        Task get_return_object() {
+            return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+
+    Task(Task &&other) noexcept : handle(other.handle) { other.handle = nullptr; }
+
+    ~Task() {
+        if (handle) handle.destroy();
+    }
+
+    // Coroutine frame is released by final_suspend once the body finishes.
+    void start(Executor &executor) {
+        executor.post(handle);
+        handle = nullptr;
+    }
+
+private:
+    std::coroutine_handle<promise_type> handle;
+
+    explicit Task(std::coroutine_handle<promise_type> h) : handle(h) {}
+};
+
+class AsyncChannel {
+private:
+    struct PushAwaiter;
+    struct PopAwaiter;
+
+    CircularBuffer ring;
+    Executor &executor;
+    std::mutex lock;
+    std::deque<PushAwaiter *> pushers;
+    std::deque<PopAwaiter *> poppers;
+    bool closed;
+    [[no_unique_address]] LatencyTracer tracer;
+
+    struct PushAwaiter {
+        AsyncChannel &channel;
+        value_type item;
+        std::coroutine_handle<> handle;
+        bool accepted;
+
+        bool await_ready() const noexcept { return false; }
+
+        bool await_suspend(std::coroutine_handle<> h) {
+            std::unique_lock<std::mutex> guard(channel.lock);
+            if (channel.closed) {
+                accepted = false;
+                return false;
+            }
+            accepted = true;
+            if (!channel.poppers.empty()) {
+                PopAwaiter *popper = channel.poppers.front();
+                channel.poppers.pop_front();
+                popper->item = item;
+                channel.tracer.passed();
+                guard.unlock();
+                channel.executor.post(popper->handle);
+                return false;
+            }
+            if (!channel.ring.full()) {
+                channel.ring.push_back(item);
+                channel.tracer.pushed();
+                return false;
+            }
+            handle = h;
+            channel.pushers.push_back(this);
+            return true;
+        }
+
+        bool await_resume() const noexcept { return accepted; }
+    };
+
+    struct PopAwaiter {
+        AsyncChannel &channel;
+        std::optional<value_type> item;
+        std::coroutine_handle<> handle;
+
+        bool await_ready() const noexcept { return false; }
+
+        bool await_suspend(std::coroutine_handle<> h) {
+            std::unique_lock<std::mutex> guard(channel.lock);
+            if (!channel.ring.empty()) {
+                item = channel.ring.front();
+                channel.ring.pop_front();
+                channel.tracer.popped();
+                if (!channel.pushers.empty()) {
+                    PushAwaiter *pusher = channel.pushers.front();
+                    channel.pushers.pop_front();
+                    channel.ring.push_back(pusher->item);
+                    channel.tracer.pushed();
+                    guard.unlock();
+                    channel.executor.post(pusher->handle);
+                }
+                return false;
+            }
+            if (channel.closed) return false;
+            handle = h;
+            channel.poppers.push_back(this);
+            return true;
+        }
+
+        std::optional<value_type> await_resume() noexcept { return item; }
+    };
+
+public:
+    AsyncChannel(int capacity, Executor &exec) : ring(capacity), executor(exec), closed(false), tracer(capacity) {
+        if (capacity < 1) throw std::invalid_argument("Channel capacity must be positive");
+    }
+
+    AsyncChannel(const AsyncChannel &) = delete;
+    AsyncChannel &operator=(const AsyncChannel &) = delete;
+
+    // co_await yields false if the channel was closed and the item dropped.
+    PushAwaiter push(const value_type &item) {
+        return PushAwaiter{*this, item, nullptr, false};
+    }
+
+    // co_await yields std::nullopt once the channel is closed and drained.
+    PopAwaiter pop() {
+        return PopAwaiter{*this, std::nullopt, nullptr};
+    }
+
+    void close() {
+        std::deque<PushAwaiter *> rejected;
+        std::deque<PopAwaiter *> drained;
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            closed = true;
+            rejected.swap(pushers);
+            drained.swap(poppers);
+        }
+        for (PushAwaiter *pusher : rejected) {
+            pusher->accepted = false;
+            executor.post(pusher->handle);
+        }
+        for (PopAwaiter *popper : drained) {
+            executor.post(popper->handle);
+        }
+    }
+
+    int size() {
+        std::lock_guard<std::mutex> guard(lock);
+        return ring.size();
+    }
+
+    int capacity() const { return ring.capacity(); }
+
+#ifdef RING_LATENCY_TRACE
+    const LatencyHistogram &latency() const { return tracer.histogram(); }
+#endif
+};
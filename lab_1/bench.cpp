@@ -0,0 +1,409 @@
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "perf_harness.hpp"
+#include "ring_buffer.hpp"
+#include "async_channel.hpp"
+#include "compressed_log.hpp"
+#include "combining_buffer.hpp"
+#include "ready_poller.hpp"
+#include "work_stealing.hpp"
+
+// Every benchmark region reports through the shared harness, which adds
+// hardware counters per op and handles --save / --compare baselines.
+static PerfHarness *harness;
+
+// Pipeline: source -> increment -> sink, every stage talks to the next
+// one through a bounded queue of the same capacity.
+
+static const int pipeline_items = 1000000;
+static const int pipeline_capacity = 256;
+
+static Task pipeline_source(AsyncChannel &out, std::promise<void> *done) {
+    for (int i = 0; i < pipeline_items; ++i) {
+        co_await out.push(static_cast<value_type>(i));
+    }
+    out.close();
+    if (done) done->set_value();
+}
+
+static Task pipeline_stage(AsyncChannel &in, AsyncChannel &out, std::promise<void> *done) {
+    while (std::optional<value_type> item = co_await in.pop()) {
+        co_await out.push(static_cast<value_type>(*item + 1));
+    }
+    out.close();
+    if (done) done->set_value();
+}
+
+static Task pipeline_sink(AsyncChannel &in, long &sum, std::promise<void> *done) {
+    while (std::optional<value_type> item = co_await in.pop()) {
+        sum += *item;
+    }
+    if (done) done->set_value();
+}
+
+static long bench_coroutine_inline() {
+    InlineExecutor executor;
+    AsyncChannel first(pipeline_capacity, executor);
+    AsyncChannel second(pipeline_capacity, executor);
+    long sum = 0;
+
+    harness->start();
+    pipeline_sink(second, sum, nullptr).start(executor);
+    pipeline_stage(first, second, nullptr).start(executor);
+    pipeline_source(first, nullptr).start(executor);
+    executor.run();
+    harness->stop("pipeline/coroutine inline executor", pipeline_items);
+    return sum;
+}
+
+static long bench_coroutine_pool(int threads) {
+    ThreadPoolExecutor executor(threads);
+    AsyncChannel first(pipeline_capacity, executor);
+    AsyncChannel second(pipeline_capacity, executor);
+    std::promise<void> source_done, stage_done, sink_done;
+    long sum = 0;
+
+    harness->start();
+    pipeline_sink(second, sum, &sink_done).start(executor);
+    pipeline_stage(first, second, &stage_done).start(executor);
+    pipeline_source(first, &source_done).start(executor);
+    source_done.get_future().wait();
+    stage_done.get_future().wait();
+    sink_done.get_future().wait();
+    harness->stop("pipeline/coroutine thread pool", pipeline_items);
+    return sum;
+}
+
+class BlockingQueue {
+private:
+    CircularBuffer ring;
+    std::mutex lock;
+    std::condition_variable not_empty, not_full;
+    bool closed;
+
+public:
+    explicit BlockingQueue(int capacity) : ring(capacity), closed(false) {}
+
+    void push(value_type item) {
+        std::unique_lock<std::mutex> guard(lock);
+        not_full.wait(guard, [this] { return !ring.full(); });
+        ring.push_back(item);
+        not_empty.notify_one();
+    }
+
+    bool pop(value_type &item) {
+        std::unique_lock<std::mutex> guard(lock);
+        not_empty.wait(guard, [this] { return closed || !ring.empty(); });
+        if (ring.empty()) return false;
+        item = ring.front();
+        ring.pop_front();
+        not_full.notify_one();
+        return true;
+    }
+
+    void close() {
+        std::lock_guard<std::mutex> guard(lock);
+        closed = true;
+        not_empty.notify_all();
+    }
+};
+
+static long bench_blocking_threads() {
+    BlockingQueue first(pipeline_capacity);
+    BlockingQueue second(pipeline_capacity);
+    long sum = 0;
+
+    harness->start();
+    std::thread source([&] {
+        for (int i = 0; i < pipeline_items; ++i) first.push(static_cast<value_type>(i));
+        first.close();
+    });
+    std::thread stage([&] {
+        value_type item;
+        while (first.pop(item)) second.push(static_cast<value_type>(item + 1));
+        second.close();
+    });
+    std::thread sink([&] {
+        value_type item;
+        while (second.pop(item)) sum += item;
+    });
+    source.join();
+    stage.join();
+    sink.join();
+    harness->stop("pipeline/mutex+condvar threads", pipeline_items);
+    return sum;
+}
+
+static void bench_pipeline() {
+    long inline_sum = bench_coroutine_inline();
+    long pool_sum = bench_coroutine_pool(2);
+    long blocking_sum = bench_blocking_threads();
+    if (inline_sum != pool_sum || inline_sum != blocking_sum) {
+        std::printf("pipeline checksum mismatch\n");
+    }
+}
+
+static bool equal_by_index(const CircularBuffer &a, const CircularBuffer &b) {
+    if (a.size() != b.size()) return false;
+    for (int i = 0; i < a.size(); ++i) {
+        if (a[i] != b[i]) return false;
+    }
+    return true;
+}
+
+static void bench_compare() {
+    const int capacity = 1 << 20;
+    const int rounds = 50;
+    CircularBuffer a(capacity), b(capacity);
+    for (int i = 0; i < capacity + capacity / 3; ++i) {
+        a.push_back(static_cast<value_type>(i * 31));
+        b.push_back(static_cast<value_type>(i * 31));
+    }
+    b.pop_back();
+    b.push_back('!');
+
+    int equal = 0;
+    harness->start();
+    for (int r = 0; r < rounds; ++r) equal += equal_by_index(a, b);
+    harness->stop("compare/operator[] loop (per element)", static_cast<long>(rounds) * capacity);
+
+    harness->start();
+    for (int r = 0; r < rounds; ++r) equal += a == b;
+    harness->stop("compare/segment memcmp (per element)", static_cast<long>(rounds) * capacity);
+
+    a.enable_hash();
+    b.enable_hash();
+    harness->start();
+    for (int r = 0; r < rounds; ++r) equal += a == b;
+    harness->stop("compare/rolling hash (per compare)", rounds);
+
+    if (equal != 0) std::printf("compare mismatch\n");
+}
+
+static void bench_pages(const char *label, const BufferOptions &options) {
+    const int capacity = 512 * 1024 * 1024;
+    const int probes = 20000000;
+    char name[64];
+
+    harness->start();
+    CircularBuffer ring(capacity, options);
+    std::snprintf(name, sizeof(name), "pages/%s construct", label);
+    harness->stop(name, capacity);
+
+    std::snprintf(name, sizeof(name), "pages/%s push_back", label);
+    harness->start();
+    for (int i = 0; i < capacity; ++i) ring.push_back(static_cast<value_type>(i));
+    harness->stop(name, capacity);
+
+    long sum = 0;
+    unsigned index = 12345;
+    std::snprintf(name, sizeof(name), "pages/%s random operator[]", label);
+    harness->start();
+    for (int i = 0; i < probes; ++i) {
+        index = index * 1664525u + 1013904223u;
+        sum += ring[static_cast<int>(index % capacity)];
+    }
+    harness->stop(name, probes);
+    if (sum == 42) std::printf("\n");
+}
+
+static void bench_huge_pages() {
+    BufferOptions small_pages;
+    small_pages.prefault = true;
+    BufferOptions huge_pages;
+    huge_pages.huge_pages = true;
+    huge_pages.prefault = true;
+    bench_pages("4k", small_pages);
+    bench_pages("huge", huge_pages);
+}
+
+static void bench_compressed_log() {
+    const int budget = 8 * 1024 * 1024;
+    std::string text;
+    const char *levels[] = {"INFO", "WARN", "DEBUG", "ERROR"};
+    for (int i = 0; text.size() < 64u * 1024 * 1024; ++i) {
+        char line[160];
+        int n = std::snprintf(line, sizeof(line), "2024-05-%02d 12:%02d:%02d.%03d %s worker-%d request id=%d path=/api/v1/items/%d took %dms\n",
+                              1 + i / 500000 % 28, i / 6000 % 60, i / 100 % 60, i % 1000, levels[i % 7 % 4],
+                              i % 16, 100000 + i, i % 977, i % 250);
+        text.append(line, n);
+    }
+
+    CircularBuffer plain(budget);
+    harness->start();
+    for (size_t offset = 0; offset < text.size(); offset += 4096) {
+        int n = static_cast<int>(std::min<size_t>(4096, text.size() - offset));
+        if (plain.reserve() < n) plain.consume(n - plain.reserve());
+        WriteSpan span = plain.reserve_write(n);
+        std::memcpy(span.first, text.data() + offset, span.first_size);
+        std::memcpy(span.second, text.data() + offset + span.first_size, span.second_size);
+        plain.commit_write(n);
+    }
+    harness->stop("log/plain ring append (per byte)", static_cast<long>(text.size()));
+
+    CompressedLog log(budget, 64 * 1024);
+    harness->start();
+    for (size_t offset = 0; offset < text.size(); offset += 4096) {
+        log.append(std::string_view(text).substr(offset, 4096));
+    }
+    harness->stop("log/compressed append (per byte)", static_cast<long>(text.size()));
+
+    harness->start();
+    long hit = log.find("request id=100000 ");
+    harness->stop("log/compressed find miss (per byte)", log.size());
+
+    std::printf("%-40s %10.2fx (%ld of %d bytes retained, hit=%ld)\n", "log/history retained vs plain",
+                static_cast<double>(log.size()) / plain.size(), log.size(), plain.size(), hit);
+}
+
+// Many producers feeding one ring: every push taking the shared lock
+// versus per-thread staging with one lock per batch.
+static const int combining_items = 200000;
+
+static void bench_shared_lock(const char *name, int threads) {
+    CircularBuffer ring(1 << 16);
+    std::mutex lock;
+    std::vector<std::thread> workers;
+    harness->start();
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&ring, &lock, threads] {
+            for (int i = 0; i < combining_items / threads; ++i) {
+                std::lock_guard<std::mutex> guard(lock);
+                ring.push_back(static_cast<char>(i));
+            }
+        });
+    }
+    for (std::thread &worker : workers) worker.join();
+    harness->stop(name, combining_items / threads * threads);
+}
+
+static void bench_combining(const char *name, int threads, int batch) {
+    CombiningBuffer shared(1 << 16, batch);
+    std::vector<std::thread> workers;
+    harness->start();
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&shared, threads] {
+            CombiningBuffer::Producer producer(shared);
+            for (int i = 0; i < combining_items / threads; ++i) producer.push(static_cast<char>(i));
+        });
+    }
+    for (std::thread &worker : workers) worker.join();
+    harness->stop(name, combining_items / threads * threads);
+}
+
+static void bench_combining_scaling() {
+    const int counts[] = {1, 2, 4, 8, 16, 32, 48};
+    for (int threads : counts) {
+        char name[64];
+        std::snprintf(name, sizeof(name), "producers/%d shared lock", threads);
+        bench_shared_lock(name, threads);
+        std::snprintf(name, sizeof(name), "producers/%d combining x64", threads);
+        bench_combining(name, threads, 64);
+    }
+}
+
+// Finding work among many streams: scanning every ring versus taking
+// ready ids from the poller, with only a few streams active per round.
+static void bench_ready_poller() {
+    const int streams = 10000, active = 16, rounds = 2000;
+    std::vector<CircularBuffer> rings(streams, CircularBuffer(16));
+    char out[16];
+    long found = 0;
+    harness->start();
+    for (int r = 0; r < rounds; ++r) {
+        for (int a = 0; a < active; ++a) rings[(r * 7919 + a * 613) % streams].push_back('x');
+        for (CircularBuffer &ring : rings) {
+            while (!ring.empty()) {
+                ring.pop_front();
+                ++found;
+            }
+        }
+    }
+    harness->stop("poll/scan all rings (per round)", rounds);
+
+    ReadyPoller poller;
+    for (int i = 0; i < streams; ++i) poller.add_ring(16);
+    int ids[active];
+    harness->start();
+    for (int r = 0; r < rounds; ++r) {
+        for (int a = 0; a < active; ++a) poller.ring((r * 7919 + a * 613) % streams).push_back('x');
+        int n;
+        while ((n = poller.try_wait(ids, active)) > 0) {
+            for (int i = 0; i < n; ++i) found -= poller.ring(ids[i]).drain(out, 16);
+        }
+    }
+    harness->stop("poll/ready list (per round)", rounds);
+#ifdef RING_LATENCY_TRACE
+    const LatencyHistogram &dwell = poller.ring(0).latency();
+    std::printf("%-40s p50 %.0f ns, p99 %.0f ns, max %.0f ns\n", "poll/ring 0 dwell", dwell.percentile_ns(50),
+                dwell.percentile_ns(99), dwell.max_ns());
+#endif
+    if (found != 0) std::printf("poll/mismatch %ld\n", found);
+}
+
+// Fine-grained fork/join: recursive halving down to small leaves, so the
+// scheduler overhead per job dominates unless stealing is cheap.
+static long sum_range(WorkStealingPool &pool, const int *data, long n, long grain) {
+    if (n <= grain) {
+        long sum = 0;
+        for (long i = 0; i < n; ++i) sum += data[i];
+        return sum;
+    }
+    long half = n / 2;
+    long left = 0;
+    TaskGroup group;
+    pool.spawn(group, [&] { left = sum_range(pool, data, half, grain); });
+    long right = sum_range(pool, data + half, n - half, grain);
+    pool.wait(group);
+    return left + right;
+}
+
+static void bench_work_stealing() {
+    const long n = 1 << 24;
+    const long grain = 2048;
+    std::vector<int> data(n);
+    for (long i = 0; i < n; ++i) data[i] = static_cast<int>(i & 1023);
+
+    long expected = 0;
+    harness->start();
+    for (long i = 0; i < n; ++i) expected += data[i];
+    harness->stop("steal/sequential sum (per element)", n);
+
+    int cores = static_cast<int>(std::thread::hardware_concurrency());
+    if (cores < 1) cores = 1;
+    for (int threads = 1;; threads *= 2) {
+        if (threads > cores) threads = cores;
+        WorkStealingPool pool(threads);
+        char name[64];
+        std::snprintf(name, sizeof(name), "steal/parallel sum x%d (per element)", threads);
+        long result = 0;
+        harness->start();
+        TaskGroup group;
+        pool.spawn(group, [&] { result = sum_range(pool, data.data(), n, grain); });
+        pool.wait(group);
+        harness->stop(name, n);
+        if (result != expected) std::printf("steal/checksum mismatch\n");
+        if (threads == cores) break;
+    }
+}
+
+int main(int argc, char **argv) {
+    PerfHarness perf(argc, argv);
+    harness = &perf;
+    bench_pipeline();
+    bench_compare();
+    bench_huge_pages();
+    bench_compressed_log();
+    bench_combining_scaling();
+    bench_ready_poller();
+    bench_work_stealing();
+    return 0;
+}
@@ -0,0 +1,191 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+#include "ring_buffer.hpp"
+#include "latency_trace.hpp"
+
+// Shared ring fed by many threads. Each thread pushes into its own
+// Producer, which stages items locally and publishes them as one batch
+// under a single lock and index update. Items of one producer stay in
+// order; like push_back, publishing overwrites the oldest items when the
+// shared ring is full.
+class CombiningBuffer {
+public:
+    typedef std::chrono::steady_clock clock;
+
+    class Producer {
+    private:
+        friend class CombiningBuffer;
+
+        CombiningBuffer &shared;
+        CircularBuffer staging;
+        clock::time_point oldest;
+        // With a flush interval the consumer may publish an idle producer's
+        // batch, so staging is then guarded and the deadline is readable
+        // without the lock.
+        std::mutex staging_lock;
+        std::atomic<clock::rep> deadline;
+
+        bool timed() const { return shared.flush_interval.count() > 0; }
+
+        std::unique_lock<std::mutex> guard_staging() {
+            std::unique_lock<std::mutex> guard(staging_lock, std::defer_lock);
+            if (timed()) guard.lock();
+            return guard;
+        }
+
+        // Caller holds the staging guard.
+        void publish_staged() {
+            if (!staging.empty()) shared.publish(staging);
+            deadline.store(clock::time_point::max().time_since_epoch().count(), std::memory_order_relaxed);
+        }
+
+        void flush_if_expired(clock::time_point now) {
+            if (deadline.load(std::memory_order_relaxed) > now.time_since_epoch().count()) return;
+            std::lock_guard<std::mutex> guard(staging_lock);
+            if (!staging.empty() && now - oldest >= shared.flush_interval) publish_staged();
+        }
+
+    public:
+        explicit Producer(CombiningBuffer &buffer)
+            : shared(buffer), staging(buffer.batch_size),
+              deadline(clock::time_point::max().time_since_epoch().count()) {
+            if (timed()) shared.enroll(this);
+        }
+
+        Producer(const Producer &) = delete;
+        Producer &operator=(const Producer &) = delete;
+
+        ~Producer() {
+            flush();
+            if (timed()) shared.withdraw(this);
+        }
+
+        // Publishes when the batch is full, or once the oldest staged item
+        // has waited flush_interval: on the next push, or on the consumer's
+        // next pop if this producer has gone idle.
+        void push(const value_type &item) {
+            std::unique_lock<std::mutex> guard = guard_staging();
+            if (timed() && staging.empty()) {
+                oldest = clock::now();
+                deadline.store((oldest + shared.flush_interval).time_since_epoch().count(), std::memory_order_relaxed);
+            }
+            staging.push_back(item);
+            if (staging.full() || (timed() && clock::now() - oldest >= shared.flush_interval)) {
+                publish_staged();
+            }
+        }
+
+        void flush() {
+            std::unique_lock<std::mutex> guard = guard_staging();
+            publish_staged();
+        }
+
+        int staged() {
+            std::unique_lock<std::mutex> guard = guard_staging();
+            return staging.size();
+        }
+    };
+
+private:
+    CircularBuffer ring;
+    std::mutex lock;
+    int batch_size;
+    clock::duration flush_interval;
+    [[no_unique_address]] LatencyTracer tracer;
+    // Producers with a flush interval, for consumer-side deadline checks.
+    // Lock order: producers_lock, then a producer's staging_lock, then lock.
+    std::mutex producers_lock;
+    std::vector<Producer *> producers;
+
+    void enroll(Producer *producer) {
+        std::lock_guard<std::mutex> guard(producers_lock);
+        producers.push_back(producer);
+    }
+
+    void withdraw(Producer *producer) {
+        std::lock_guard<std::mutex> guard(producers_lock);
+        producers.erase(std::find(producers.begin(), producers.end(), producer));
+    }
+
+    void publish(CircularBuffer &staging) {
+        int n = staging.size();
+        ReadSpan src = staging.peek_read(n);
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            if (ring.reserve() < n) ring.consume(n - ring.reserve());
+            WriteSpan dst = ring.reserve_write(n);
+            value_type *out = dst.first;
+            int room = dst.first_size;
+            const value_type *pieces[2] = {src.first, src.second};
+            int sizes[2] = {src.first_size, src.second_size};
+            for (int p = 0; p < 2; ++p) {
+                const value_type *in = pieces[p];
+                int left = sizes[p];
+                while (left > 0) {
+                    if (room == 0) {
+                        out = dst.second;
+                        room = dst.second_size;
+                    }
+                    int k = std::min(left, room);
+                    std::copy(in, in + k, out);
+                    in += k;
+                    out += k;
+                    left -= k;
+                    room -= k;
+                }
+            }
+            ring.commit_write(n);
+            tracer.pushed(n);
+        }
+        staging.consume(n);
+    }
+
+public:
+    CombiningBuffer(int capacity, int batch, clock::duration interval = clock::duration::zero())
+        : ring(capacity), batch_size(batch), flush_interval(interval), tracer(capacity) {
+        if (batch < 1 || batch > capacity) throw std::invalid_argument("Batch size must be within capacity");
+    }
+
+    CombiningBuffer(const CombiningBuffer &) = delete;
+    CombiningBuffer &operator=(const CombiningBuffer &) = delete;
+
+    // Publishes the batches of producers whose oldest staged item has
+    // waited flush_interval. pop calls it; a consumer may also call it
+    // before checking size().
+    void flush_expired() {
+        if (flush_interval.count() <= 0) return;
+        clock::time_point now = clock::now();
+        std::lock_guard<std::mutex> guard(producers_lock);
+        for (Producer *producer : producers) producer->flush_if_expired(now);
+    }
+
+    // Copies up to n oldest items into out and removes them.
+    int pop(value_type *out, int n) {
+        flush_expired();
+        std::lock_guard<std::mutex> guard(lock);
+        ReadSpan span = ring.peek_read(n);
+        std::copy(span.first, span.first + span.first_size, out);
+        std::copy(span.second, span.second + span.second_size, out + span.first_size);
+        ring.consume(span.size());
+        tracer.popped(span.size());
+        return span.size();
+    }
+
+    int size() {
+        std::lock_guard<std::mutex> guard(lock);
+        return ring.size();
+    }
+
+    int capacity() const { return ring.capacity(); }
+    int batch() const { return batch_size; }
+
+#ifdef RING_LATENCY_TRACE
+    const LatencyHistogram &latency() const { return tracer.histogram(); }
+#endif
+};
@@ -0,0 +1,229 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "ring_buffer.hpp"
+
+// Byte-oriented LZ77 codec in the LZ4 sequence format: a token byte with
+// literal length (high nibble) and match length - 4 (low nibble), both
+// extended by 255-runs, the literals, then a 2-byte little-endian offset.
+// The last sequence carries literals only.
+
+const int lz_min_match = 4;
+const int lz_max_offset = 65535;
+const int lz_hash_bits = 12;
+
+inline int lz_bound(int n) {
+    return n + n / 255 + 16;
+}
+
+inline std::uint32_t lz_load32(const char *p) {
+    std::uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline void lz_put_length(std::vector<char> &out, int len) {
+    while (len >= 255) {
+        out.push_back(static_cast<char>(255));
+        len -= 255;
+    }
+    out.push_back(static_cast<char>(len));
+}
+
+inline void lz_put_sequence(std::vector<char> &out, const char *literals, int literal_len, int offset, int match_len) {
+    int match_code = match_len == 0 ? 0 : match_len - lz_min_match;
+    unsigned char token = static_cast<unsigned char>((std::min(literal_len, 15) << 4) | std::min(match_code, 15));
+    out.push_back(static_cast<char>(token));
+    if (literal_len >= 15) lz_put_length(out, literal_len - 15);
+    out.insert(out.end(), literals, literals + literal_len);
+    if (match_len == 0) return;
+    out.push_back(static_cast<char>(offset & 0xff));
+    out.push_back(static_cast<char>(offset >> 8));
+    if (match_code >= 15) lz_put_length(out, match_code - 15);
+}
+
+inline void lz_compress(const char *src, int n, std::vector<char> &out) {
+    out.clear();
+    int table[1 << lz_hash_bits];
+    std::fill(table, table + (1 << lz_hash_bits), -1);
+
+    int anchor = 0;
+    int pos = 0;
+    int limit = n - lz_min_match;
+    while (pos < limit) {
+        std::uint32_t word = lz_load32(src + pos);
+        int slot = static_cast<int>((word * 2654435761u) >> (32 - lz_hash_bits));
+        int candidate = table[slot];
+        table[slot] = pos;
+        if (candidate < 0 || pos - candidate > lz_max_offset || lz_load32(src + candidate) != word) {
+            ++pos;
+            continue;
+        }
+        int match_len = lz_min_match;
+        while (pos + match_len < n && src[candidate + match_len] == src[pos + match_len]) ++match_len;
+        lz_put_sequence(out, src + anchor, pos - anchor, pos - candidate, match_len);
+        pos += match_len;
+        anchor = pos;
+    }
+    lz_put_sequence(out, src + anchor, n - anchor, 0, 0);
+}
+
+inline int lz_get_length(const char *&p, const char *end, int len) {
+    unsigned char b;
+    do {
+        if (p >= end) throw std::runtime_error("Corrupt compressed block");
+        b = static_cast<unsigned char>(*p++);
+        len += b;
+    } while (b == 255);
+    return len;
+}
+
+// Returns the number of bytes written to dst (at most capacity).
+inline int lz_decompress(const char *src, int n, char *dst, int capacity) {
+    const char *p = src;
+    const char *end = src + n;
+    int out = 0;
+    while (p < end) {
+        unsigned char token = static_cast<unsigned char>(*p++);
+        int literal_len = token >> 4;
+        if (literal_len == 15) literal_len = lz_get_length(p, end, literal_len);
+        if (literal_len > end - p || literal_len > capacity - out) throw std::runtime_error("Corrupt compressed block");
+        std::memcpy(dst + out, p, literal_len);
+        p += literal_len;
+        out += literal_len;
+        if (p == end) break;
+
+        if (end - p < 2) throw std::runtime_error("Corrupt compressed block");
+        int offset = static_cast<unsigned char>(p[0]) | (static_cast<unsigned char>(p[1]) << 8);
+        p += 2;
+        int match_len = token & 15;
+        if (match_len == 15) match_len = lz_get_length(p, end, match_len);
+        match_len += lz_min_match;
+        if (offset == 0 || offset > out || match_len > capacity - out) throw std::runtime_error("Corrupt compressed block");
+        for (int i = 0; i < match_len; ++i, ++out) {
+            dst[out] = dst[out - offset];
+        }
+    }
+    return out;
+}
+
+// Text log that keeps its history as compressed fixed-size blocks inside
+// a CircularBuffer byte budget. Appends fill an open block; a full block
+// is sealed (compressed) and the oldest sealed blocks are evicted whole
+// to make room. Reads decompress on demand.
+class CompressedLog {
+private:
+    struct Block {
+        int stored;
+        int raw;
+    };
+
+    CircularBuffer store;
+    std::deque<Block> blocks;
+    std::vector<char> open_block;
+    std::vector<char> scratch;
+    int block_size;
+    long raw_total;
+
+    void seal() {
+        if (open_block.empty()) return;
+        lz_compress(open_block.data(), static_cast<int>(open_block.size()), scratch);
+        int stored = static_cast<int>(scratch.size());
+        while (store.reserve() < stored) {
+            store.consume(blocks.front().stored);
+            raw_total -= blocks.front().raw;
+            blocks.pop_front();
+        }
+        WriteSpan span = store.reserve_write(stored);
+        std::copy(scratch.begin(), scratch.begin() + span.first_size, span.first);
+        std::copy(scratch.begin() + span.first_size, scratch.end(), span.second);
+        store.commit_write(stored);
+        blocks.push_back(Block{stored, static_cast<int>(open_block.size())});
+        open_block.clear();
+    }
+
+    void read_stored(int offset, int len, std::vector<char> &out) const {
+        ReadSpan span = store.peek_read(offset + len);
+        out.resize(len);
+        int head = std::max(0, std::min(len, span.first_size - offset));
+        // Offset into a segment only when copying from it.
+        if (head > 0) std::copy(span.first + offset, span.first + offset + head, out.begin());
+        if (len > head) {
+            const value_type *tail = span.second + (offset + head - span.first_size);
+            std::copy(tail, tail + (len - head), out.begin() + head);
+        }
+    }
+
+public:
+    CompressedLog(int capacity, int block = 64 * 1024)
+        : store(capacity), block_size(block), raw_total(0) {
+        if (block < 1) throw std::invalid_argument("Block size must be positive");
+        if (capacity < lz_bound(block)) throw std::invalid_argument("Capacity must hold at least one compressed block");
+        open_block.reserve(block);
+    }
+
+    void append(std::string_view text) {
+        while (!text.empty()) {
+            int room = block_size - static_cast<int>(open_block.size());
+            int n = std::min(room, static_cast<int>(text.size()));
+            open_block.insert(open_block.end(), text.begin(), text.begin() + n);
+            raw_total += n;
+            text.remove_prefix(n);
+            if (static_cast<int>(open_block.size()) == block_size) seal();
+        }
+    }
+
+    // Decompresses blocks oldest to newest, finishing with the open block.
+    template <class F>
+    void for_each_block(F visit) const {
+        std::vector<char> packed, raw(block_size);
+        int offset = 0;
+        for (const Block &block : blocks) {
+            read_stored(offset, block.stored, packed);
+            int n = lz_decompress(packed.data(), block.stored, raw.data(), block_size);
+            visit(std::string_view(raw.data(), n));
+            offset += block.stored;
+        }
+        if (!open_block.empty()) visit(std::string_view(open_block.data(), open_block.size()));
+    }
+
+    std::string text() const {
+        std::string out;
+        out.reserve(raw_total);
+        for_each_block([&out](std::string_view block) { out.append(block); });
+        return out;
+    }
+
+    // Offset of the first match from the oldest retained byte, or -1.
+    long find(std::string_view needle) const {
+        if (needle.empty()) return 0;
+        std::string window;
+        long window_start = 0;
+        long found = -1;
+        for_each_block([&](std::string_view block) {
+            if (found >= 0) return;
+            window.append(block);
+            size_t at = window.find(needle);
+            if (at != std::string::npos) {
+                found = window_start + static_cast<long>(at);
+                return;
+            }
+            size_t keep = std::min(window.size(), needle.size() - 1);
+            window_start += static_cast<long>(window.size() - keep);
+            window.erase(0, window.size() - keep);
+        });
+        return found;
+    }
+
+    long size() const { return raw_total; }
+    int stored_bytes() const { return store.size() + static_cast<int>(open_block.size()); }
+    int sealed_blocks() const { return static_cast<int>(blocks.size()); }
+    int capacity() const { return store.capacity(); }
+};
@@ -0,0 +1,181 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include "ring_buffer.hpp"
+
+// Storage chunk plus the number of snapshots that still read it. The
+// shared_ptr only manages lifetime; the copy-on-write decision uses readers.
+// A snapshot drops its reader with a release decrement, and the owner checks
+// with an acquire load, so a snapshot's last reads on any thread happen
+// before the owner writes the chunk in place.
+struct ChunkStorage {
+    std::vector<value_type> values;
+    std::atomic<int> readers{0};
+
+    explicit ChunkStorage(int size) : values(size) {}
+    explicit ChunkStorage(const std::vector<value_type> &v) : values(v) {}
+};
+
+typedef std::shared_ptr<ChunkStorage> BufferChunk;
+
+// Read-only view that shares storage chunks with the CowCircularBuffer it
+// was taken from. Snapshots may be copied, read and destroyed on any thread.
+class CowSnapshot {
+private:
+    std::vector<BufferChunk> chunks;
+    int chunk_size, start, count, buf_capacity;
+
+    void acquire_chunks() {
+        for (const BufferChunk &chunk : chunks) {
+            chunk->readers.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    void release_chunks() {
+        for (const BufferChunk &chunk : chunks) {
+            chunk->readers.fetch_sub(1, std::memory_order_release);
+        }
+    }
+
+public:
+    CowSnapshot(const std::vector<BufferChunk> &c, int chunk, int first, int size, int capacity)
+        : chunks(c), chunk_size(chunk), start(first), count(size), buf_capacity(capacity) {
+        acquire_chunks();
+    }
+
+    CowSnapshot(const CowSnapshot &other)
+        : chunks(other.chunks), chunk_size(other.chunk_size), start(other.start),
+          count(other.count), buf_capacity(other.buf_capacity) {
+        acquire_chunks();
+    }
+
+    CowSnapshot(CowSnapshot &&other) noexcept
+        : chunks(std::move(other.chunks)), chunk_size(other.chunk_size), start(other.start),
+          count(other.count), buf_capacity(other.buf_capacity) {
+        other.chunks.clear();
+        other.count = 0;
+    }
+
+    CowSnapshot &operator=(CowSnapshot other) noexcept {
+        std::swap(chunks, other.chunks);
+        std::swap(chunk_size, other.chunk_size);
+        std::swap(start, other.start);
+        std::swap(count, other.count);
+        std::swap(buf_capacity, other.buf_capacity);
+        return *this;
+    }
+
+    ~CowSnapshot() {
+        release_chunks();
+    }
+
+    const value_type &operator[](int i) const {
+        int pos = (start + i) % buf_capacity;
+        return chunks[pos / chunk_size]->values[pos % chunk_size];
+    }
+
+    const value_type &at(int i) const {
+        if (i < 0 || i >= count) throw std::out_of_range("Index out of range");
+        return (*this)[i];
+    }
+
+    int size() const { return count; }
+    bool empty() const { return count == 0; }
+};
+
+// Ring stored as fixed-size shared chunks. snapshot() only copies chunk
+// pointers; the owner clones a chunk on its first write after a snapshot.
+class CowCircularBuffer {
+private:
+    std::vector<BufferChunk> chunks;
+    int chunk_size, start, end, count, buf_capacity;
+
+    value_type &writable(int pos) {
+        BufferChunk &chunk = chunks[pos / chunk_size];
+        if (chunk->readers.load(std::memory_order_acquire) > 0) {
+            chunk = std::make_shared<ChunkStorage>(chunk->values);
+        }
+        return chunk->values[pos % chunk_size];
+    }
+
+    const value_type &readable(int pos) const {
+        return chunks[pos / chunk_size]->values[pos % chunk_size];
+    }
+
+public:
+    explicit CowCircularBuffer(int capacity, int chunk = 4096)
+        : chunk_size(chunk), start(0), end(0), count(0), buf_capacity(capacity) {
+        if (capacity < 1) throw std::invalid_argument("Capacity must be positive");
+        if (chunk < 1) throw std::invalid_argument("Chunk size must be positive");
+        int chunk_count = (capacity + chunk - 1) / chunk;
+        for (int i = 0; i < chunk_count; ++i) {
+            chunks.push_back(std::make_shared<ChunkStorage>(chunk));
+        }
+    }
+
+    value_type &operator[](int i) {
+        return writable((start + i) % buf_capacity);
+    }
+
+    const value_type &operator[](int i) const {
+        return readable((start + i) % buf_capacity);
+    }
+
+    const value_type &at(int i) const {
+        if (i < 0 || i >= count) throw std::out_of_range("Index out of range");
+        return (*this)[i];
+    }
+
+    const value_type &front() const { return readable(start); }
+    const value_type &back() const { return readable((end - 1 + buf_capacity) % buf_capacity); }
+
+    int size() const { return count; }
+    bool empty() const { return count == 0; }
+    bool full() const { return count == buf_capacity; }
+    int capacity() const { return buf_capacity; }
+    int chunk() const { return chunk_size; }
+
+    void push_back(const value_type &item = value_type()) {
+        if (full()) {
+            start = (start + 1) % buf_capacity;
+        }
+        writable(end) = item;
+        end = (end + 1) % buf_capacity;
+        count = std::min(count + 1, buf_capacity);
+    }
+
+    void pop_front() {
+        if (empty()) throw std::underflow_error("Buffer is empty");
+        start = (start + 1) % buf_capacity;
+        --count;
+    }
+
+    void pop_back() {
+        if (empty()) throw std::underflow_error("Buffer is empty");
+        end = (end - 1 + buf_capacity) % buf_capacity;
+        --count;
+    }
+
+    void clear() {
+        start = 0;
+        end = 0;
+        count = 0;
+    }
+
+    CowSnapshot snapshot() const {
+        return CowSnapshot(chunks, chunk_size, start, count, buf_capacity);
+    }
+
+    // Number of chunks currently shared with at least one snapshot.
+    int shared_chunks() const {
+        int shared = 0;
+        for (const BufferChunk &chunk : chunks) {
+            if (chunk->readers.load(std::memory_order_acquire) > 0) ++shared;
+        }
+        return shared;
+    }
+};
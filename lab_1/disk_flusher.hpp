@@ -0,0 +1,352 @@
+#pragma once
+
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <unistd.h>
+#include "ring_buffer.hpp"
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#define RING_HAVE_IO_URING 1
+#endif
+
+struct FlushRequest {
+    const value_type *data;
+    int length;
+    long offset;
+    int result;
+    std::atomic<bool> done;
+};
+
+class FlushBackend {
+public:
+    virtual ~FlushBackend() {}
+    virtual void submit(FlushRequest *request) = 0;
+    // Marks finished requests as done; never blocks.
+    virtual void poll() = 0;
+    // Blocks until at least one more request has finished.
+    virtual void wait() = 0;
+};
+
+inline int pwrite_all(int fd, const value_type *data, int length, long offset) {
+    int written = 0;
+    while (written < length) {
+        ssize_t n = ::pwrite(fd, data + written, length - written, offset + written);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -errno;
+        }
+        written += static_cast<int>(n);
+    }
+    return written;
+}
+
+class ThreadFlushBackend : public FlushBackend {
+private:
+    int fd;
+    std::deque<FlushRequest *> queue;
+    std::mutex lock;
+    std::condition_variable queued, finished;
+    long completed, seen;
+    bool stopping;
+    std::thread worker;
+
+    void work() {
+        while (true) {
+            FlushRequest *request;
+            {
+                std::unique_lock<std::mutex> guard(lock);
+                queued.wait(guard, [this] { return stopping || !queue.empty(); });
+                if (queue.empty()) return;
+                request = queue.front();
+                queue.pop_front();
+            }
+            request->result = pwrite_all(fd, request->data, request->length, request->offset);
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                request->done.store(true, std::memory_order_release);
+                ++completed;
+            }
+            finished.notify_all();
+        }
+    }
+
+public:
+    explicit ThreadFlushBackend(int file)
+        : fd(file), completed(0), seen(0), stopping(false), worker([this] { work(); }) {}
+
+    ~ThreadFlushBackend() {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            stopping = true;
+        }
+        queued.notify_all();
+        worker.join();
+    }
+
+    void submit(FlushRequest *request) override {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            queue.push_back(request);
+        }
+        queued.notify_one();
+    }
+
+    void poll() override {}
+
+    void wait() override {
+        std::unique_lock<std::mutex> guard(lock);
+        finished.wait(guard, [this] { return completed != seen; });
+        seen = completed;
+    }
+};
+
+#ifdef RING_HAVE_IO_URING
+class IoUringFlushBackend : public FlushBackend {
+private:
+    int fd, ring_fd;
+    void *sq_map, *cq_map;
+    size_t sq_map_size, cq_map_size, sqes_size;
+    io_uring_sqe *sqes;
+    unsigned *sq_tail, *sq_mask, *sq_array;
+    unsigned *cq_head, *cq_tail, *cq_mask;
+    io_uring_cqe *cqes;
+
+    int enter(unsigned to_submit, unsigned min_complete, unsigned flags) {
+        return static_cast<int>(syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, nullptr, 0));
+    }
+
+    // Kernels 5.1-5.5 accept io_uring_setup but not IORING_OP_WRITE, so every
+    // write would complete with -EINVAL. IORING_REGISTER_PROBE arrived in the
+    // same release as IORING_OP_WRITE, so a failed probe also means no write.
+    bool supports_write() {
+        const unsigned ops = IORING_OP_WRITE + 1;
+        alignas(io_uring_probe) unsigned char storage[sizeof(io_uring_probe) + ops * sizeof(io_uring_probe_op)] = {};
+        io_uring_probe *probe = reinterpret_cast<io_uring_probe *>(storage);
+        if (syscall(__NR_io_uring_register, ring_fd, IORING_REGISTER_PROBE, probe, ops) < 0) return false;
+        return probe->ops_len > IORING_OP_WRITE && (probe->ops[IORING_OP_WRITE].flags & IO_URING_OP_SUPPORTED);
+    }
+
+    void release() {
+        if (sqes) munmap(sqes, sqes_size);
+        if (cq_map != MAP_FAILED) munmap(cq_map, cq_map_size);
+        if (sq_map != MAP_FAILED) munmap(sq_map, sq_map_size);
+        close(ring_fd);
+    }
+
+public:
+    IoUringFlushBackend(int file, unsigned entries) : fd(file), sq_map(MAP_FAILED), cq_map(MAP_FAILED), sqes(nullptr) {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        ring_fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+        if (ring_fd < 0) throw std::runtime_error("io_uring_setup failed");
+
+        sq_map_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_map_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+        sq_map = mmap(nullptr, sq_map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+        cq_map = mmap(nullptr, cq_map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_CQ_RING);
+        void *sqe_map = mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+        if (sq_map == MAP_FAILED || cq_map == MAP_FAILED || sqe_map == MAP_FAILED) {
+            if (sqe_map != MAP_FAILED) munmap(sqe_map, sqes_size);
+            release();
+            throw std::runtime_error("io_uring mmap failed");
+        }
+        sqes = static_cast<io_uring_sqe *>(sqe_map);
+
+        char *sq = static_cast<char *>(sq_map);
+        sq_tail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+        sq_mask = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+        sq_array = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+        char *cq = static_cast<char *>(cq_map);
+        cq_head = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+        cq_tail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+        cq_mask = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+
+        if (!supports_write()) {
+            release();
+            throw std::runtime_error("io_uring does not support IORING_OP_WRITE");
+        }
+    }
+
+    ~IoUringFlushBackend() {
+        release();
+    }
+
+    void submit(FlushRequest *request) override {
+        unsigned tail = *sq_tail;
+        unsigned index = tail & *sq_mask;
+        io_uring_sqe *sqe = &sqes[index];
+        std::memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode = IORING_OP_WRITE;
+        sqe->fd = fd;
+        sqe->addr = reinterpret_cast<unsigned long>(request->data);
+        sqe->len = static_cast<unsigned>(request->length);
+        sqe->off = static_cast<unsigned long>(request->offset);
+        sqe->user_data = reinterpret_cast<unsigned long>(request);
+        sq_array[index] = index;
+        __atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+        if (enter(1, 0, 0) < 0) throw std::runtime_error("io_uring_enter failed");
+    }
+
+    void poll() override {
+        unsigned head = *cq_head;
+        unsigned tail = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+        while (head != tail) {
+            io_uring_cqe *cqe = &cqes[head & *cq_mask];
+            FlushRequest *request = reinterpret_cast<FlushRequest *>(cqe->user_data);
+            request->result = cqe->res;
+            request->done.store(true, std::memory_order_release);
+            ++head;
+        }
+        __atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+    }
+
+    void wait() override {
+        if (enter(0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR) {
+            throw std::runtime_error("io_uring_enter failed");
+        }
+        poll();
+    }
+};
+#endif
+
+// Streams bytes from a CircularBuffer to a file. Full segments are
+// submitted asynchronously (io_uring when the kernel supports
+// IORING_OP_WRITE, otherwise a writer thread doing pwrite); their space is released only after the write
+// completes. write() blocks only when the ring has no free space left.
+class DiskFlusher {
+public:
+    enum Mode { automatic, uring, threaded };
+
+private:
+    int fd;
+    CircularBuffer ring;
+    int segment_size, max_in_flight;
+    long file_offset;
+    int submitted;
+    std::deque<std::unique_ptr<FlushRequest>> in_flight;
+    std::unique_ptr<FlushBackend> backend;
+    bool ring_backend;
+
+    void submit_segment(int length) {
+        ReadSpan span = ring.peek_read(submitted + length);
+        const value_type *data = submitted < span.first_size
+            ? span.first + submitted
+            : span.second + (submitted - span.first_size);
+        int contiguous = submitted < span.first_size ? span.first_size - submitted : span.size() - submitted;
+        length = std::min(length, contiguous);
+
+        std::unique_ptr<FlushRequest> request(new FlushRequest());
+        request->data = data;
+        request->length = length;
+        request->offset = file_offset;
+        request->result = 0;
+        request->done.store(false);
+        backend->submit(request.get());
+        in_flight.push_back(std::move(request));
+        file_offset += length;
+        submitted += length;
+    }
+
+    void submit_ready(bool partial) {
+        while (static_cast<int>(in_flight.size()) < max_in_flight) {
+            int pending = ring.size() - submitted;
+            if (pending == 0 || (!partial && pending < segment_size)) return;
+            submit_segment(std::min(pending, segment_size));
+        }
+    }
+
+    void reap() {
+        backend->poll();
+        while (!in_flight.empty() && in_flight.front()->done.load(std::memory_order_acquire)) {
+            FlushRequest &request = *in_flight.front();
+            if (request.result < 0) throw std::runtime_error(std::strerror(-request.result));
+            if (request.result < request.length) {
+                int rest = request.length - request.result;
+                int n = pwrite_all(fd, request.data + request.result, rest, request.offset + request.result);
+                if (n < 0) throw std::runtime_error(std::strerror(-n));
+            }
+            ring.consume(request.length);
+            submitted -= request.length;
+            in_flight.pop_front();
+        }
+    }
+
+public:
+    DiskFlusher(int file, int capacity, int segment, int max_writes = 4, long offset = 0, Mode mode = automatic)
+        : fd(file), ring(capacity), segment_size(segment), max_in_flight(max_writes), file_offset(offset),
+          submitted(0), ring_backend(false) {
+        if (segment < 1 || segment > capacity) throw std::invalid_argument("Segment size must be within capacity");
+        if (max_writes < 1) throw std::invalid_argument("At least one write must be allowed in flight");
+#ifdef RING_HAVE_IO_URING
+        if (mode != threaded) {
+            try {
+                backend.reset(new IoUringFlushBackend(fd, static_cast<unsigned>(max_writes)));
+                ring_backend = true;
+            } catch (const std::runtime_error &) {
+                if (mode == uring) throw;
+            }
+        }
+#else
+        if (mode == uring) throw std::runtime_error("io_uring is not available");
+#endif
+        if (!backend) backend.reset(new ThreadFlushBackend(fd));
+    }
+
+    ~DiskFlusher() {
+        try {
+            flush();
+        } catch (...) {
+        }
+    }
+
+    DiskFlusher(const DiskFlusher &) = delete;
+    DiskFlusher &operator=(const DiskFlusher &) = delete;
+
+    // Copies as much as currently fits without waiting.
+    int try_write(const value_type *data, int n) {
+        reap();
+        WriteSpan span = ring.reserve_write(n);
+        std::copy(data, data + span.first_size, span.first);
+        std::copy(data + span.first_size, data + span.size(), span.second);
+        ring.commit_write(span.size());
+        submit_ready(false);
+        return span.size();
+    }
+
+    void write(const value_type *data, int n) {
+        while (true) {
+            int k = try_write(data, n);
+            data += k;
+            n -= k;
+            if (n == 0) return;
+            submit_ready(true);
+            backend->wait();
+        }
+    }
+
+    // Submits the partial tail segment and waits for every write.
+    void flush() {
+        while (true) {
+            reap();
+            submit_ready(true);
+            if (in_flight.empty()) return;
+            backend->wait();
+        }
+    }
+
+    int pending() const { return ring.size(); }
+    int writes_in_flight() const { return static_cast<int>(in_flight.size()); }
+    bool uses_io_uring() const { return ring_backend; }
+};
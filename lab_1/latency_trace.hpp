@@ -0,0 +1,171 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define RING_LATENCY_RDTSC 1
+#endif
+
+// Push-to-pop latency tracing for the queue types. Define
+// RING_LATENCY_TRACE to make them stamp every element on push and record
+// its dwell time on pop; without it LatencyTracer is an empty type and
+// every hook is a no-op.
+
+inline std::uint64_t latency_ticks() {
+#ifdef RING_LATENCY_RDTSC
+    return __rdtsc();
+#else
+    // steady_clock is CLOCK_MONOTONIC on Linux, read through the vDSO; the
+    // coarse clock only advances once per jiffy, too slow for queue dwell.
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+// Measured once against steady_clock when rdtsc is the tick source.
+inline double latency_ticks_per_ns() {
+#ifdef RING_LATENCY_RDTSC
+    static const double rate = [] {
+        std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+        std::uint64_t start = __rdtsc();
+        while (std::chrono::steady_clock::now() - begin < std::chrono::milliseconds(10)) {
+        }
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count();
+        return (__rdtsc() - start) / ns;
+    }();
+    return rate;
+#else
+    return 1.0;
+#endif
+}
+
+// Log-linear histogram of tick counts: values below 16 get exact buckets,
+// larger ones 16 buckets per power of two, so any bucket is within 1/16
+// of its values. There is one writer (the queue, under its lock); readers
+// may export percentiles at any time without stopping it.
+class LatencyHistogram {
+public:
+    static const int sub_buckets = 16;
+    static const int bucket_count = 61 * sub_buckets;
+
+private:
+    std::atomic<std::uint64_t> counts[bucket_count];
+    std::atomic<std::uint64_t> largest;
+
+    static int bucket_of(std::uint64_t ticks) {
+        if (ticks < sub_buckets) return static_cast<int>(ticks);
+        int msb = 63 - __builtin_clzll(ticks);
+        return (msb - 3) * sub_buckets + static_cast<int>(ticks >> (msb - 4)) - sub_buckets;
+    }
+
+    static std::uint64_t bucket_floor(int bucket) {
+        if (bucket < sub_buckets) return bucket;
+        int msb = bucket / sub_buckets + 3;
+        return static_cast<std::uint64_t>(bucket % sub_buckets + sub_buckets) << (msb - 4);
+    }
+
+public:
+    LatencyHistogram() {
+        reset();
+    }
+
+    LatencyHistogram(const LatencyHistogram &) = delete;
+    LatencyHistogram &operator=(const LatencyHistogram &) = delete;
+
+    void record(std::uint64_t ticks) {
+        std::atomic<std::uint64_t> &slot = counts[bucket_of(ticks)];
+        slot.store(slot.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        if (ticks > largest.load(std::memory_order_relaxed)) largest.store(ticks, std::memory_order_relaxed);
+    }
+
+    void reset() {
+        for (std::atomic<std::uint64_t> &slot : counts) slot.store(0, std::memory_order_relaxed);
+        largest.store(0, std::memory_order_relaxed);
+    }
+
+    std::uint64_t count() const {
+        std::uint64_t total = 0;
+        for (const std::atomic<std::uint64_t> &slot : counts) total += slot.load(std::memory_order_relaxed);
+        return total;
+    }
+
+    // Lower bound of the bucket holding the p-th percentile (0..100), in ticks.
+    std::uint64_t percentile_ticks(double p) const {
+        std::uint64_t snapshot[bucket_count];
+        std::uint64_t total = 0;
+        for (int i = 0; i < bucket_count; ++i) {
+            snapshot[i] = counts[i].load(std::memory_order_relaxed);
+            total += snapshot[i];
+        }
+        if (total == 0) return 0;
+        std::uint64_t rank = static_cast<std::uint64_t>(p / 100.0 * (total - 1));
+        std::uint64_t seen = 0;
+        for (int i = 0; i < bucket_count; ++i) {
+            seen += snapshot[i];
+            if (seen > rank) return bucket_floor(i);
+        }
+        return bucket_floor(bucket_count - 1);
+    }
+
+    double percentile_ns(double p) const { return percentile_ticks(p) / latency_ticks_per_ns(); }
+    double max_ns() const { return largest.load(std::memory_order_relaxed) / latency_ticks_per_ns(); }
+};
+
+#ifdef RING_LATENCY_TRACE
+// Push timestamps kept in a ring parallel to the queue's elements.
+class LatencyTracer {
+private:
+    std::vector<std::uint64_t> stamps;
+    int start, count;
+    LatencyHistogram dwell;
+
+public:
+    explicit LatencyTracer(int capacity) : stamps(capacity > 0 ? capacity : 1), start(0), count(0) {}
+
+    // n elements entered the queue; like the queues, a full ring drops
+    // its oldest stamps.
+    void pushed(int n = 1) {
+        std::uint64_t now = latency_ticks();
+        int capacity = static_cast<int>(stamps.size());
+        for (int i = 0; i < n; ++i) {
+            if (count == capacity) {
+                start = (start + 1) % capacity;
+                --count;
+            }
+            stamps[(start + count) % capacity] = now;
+            ++count;
+        }
+    }
+
+    // n oldest elements left the queue.
+    void popped(int n = 1) {
+        if (n > count) n = count;
+        if (n == 0) return;
+        std::uint64_t now = latency_ticks();
+        int capacity = static_cast<int>(stamps.size());
+        for (int i = 0; i < n; ++i) {
+            std::uint64_t stamp = stamps[start];
+            dwell.record(now > stamp ? now - stamp : 0);
+            start = (start + 1) % capacity;
+        }
+        count -= n;
+    }
+
+    // Element handed straight from producer to consumer.
+    void passed() { dwell.record(0); }
+
+    const LatencyHistogram &histogram() const { return dwell; }
+};
+#else
+class LatencyTracer {
+public:
+    explicit LatencyTracer(int) {}
+    void pushed(int = 1) {}
+    void popped(int = 1) {}
+    void passed() {}
+};
+#endif
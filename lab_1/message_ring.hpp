@@ -0,0 +1,149 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+// Byte ring of variable-length records laid out as [len][payload], each
+// padded to 4 bytes. A record never straddles the wrap point: the tail
+// gap is marked with a skip header instead. When space runs out the
+// oldest whole records are evicted.
+class MessageRing {
+private:
+    static const std::uint32_t skip_marker = 0xFFFFFFFFu;
+    static const int header_size = sizeof(std::uint32_t);
+
+    std::vector<char> bytes;
+    int head, tail, used, records, buf_capacity;
+
+    static int padded(int n) { return (n + 3) & ~3; }
+
+    std::uint32_t header_at(int pos) const {
+        std::uint32_t len;
+        std::memcpy(&len, bytes.data() + pos, header_size);
+        return len;
+    }
+
+    void write_header(int pos, std::uint32_t len) {
+        std::memcpy(bytes.data() + pos, &len, header_size);
+    }
+
+    // Offset of the oldest record, stepping over a skip marker.
+    int head_record() const {
+        if (header_at(head) == skip_marker) return 0;
+        return head;
+    }
+
+    // Where a record of `need` bytes would start, or -1 if it does not fit.
+    int place(int need) const {
+        if (records > 0 && head == tail) return -1;
+        if (tail >= head) {
+            if (need <= buf_capacity - tail) return tail;
+            if (need <= head) return 0;
+            return -1;
+        }
+        return need <= head - tail ? tail : -1;
+    }
+
+public:
+    class const_iterator {
+    private:
+        const MessageRing *ring;
+        int pos, remaining;
+
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef std::string_view value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const std::string_view *pointer;
+        typedef std::string_view reference;
+
+        const_iterator() : ring(nullptr), pos(0), remaining(0) {}
+        const_iterator(const MessageRing *r, int p, int n) : ring(r), pos(p), remaining(n) {
+            if (remaining > 0 && ring->header_at(pos) == skip_marker) pos = 0;
+        }
+
+        std::string_view operator*() const {
+            return std::string_view(ring->bytes.data() + pos + header_size, ring->header_at(pos));
+        }
+
+        const_iterator &operator++() {
+            pos = (pos + header_size + padded(ring->header_at(pos))) % ring->buf_capacity;
+            if (--remaining > 0 && ring->header_at(pos) == skip_marker) pos = 0;
+            return *this;
+        }
+
+        const_iterator operator++(int) {
+            const_iterator old = *this;
+            ++*this;
+            return old;
+        }
+
+        bool operator==(const const_iterator &other) const { return remaining == other.remaining; }
+        bool operator!=(const const_iterator &other) const { return remaining != other.remaining; }
+    };
+
+    explicit MessageRing(int capacity)
+        : bytes(padded(capacity)), head(0), tail(0), used(0), records(0), buf_capacity(padded(capacity)) {
+        if (capacity < header_size) throw std::invalid_argument("Capacity too small for a record header");
+    }
+
+    int size() const { return records; }
+    bool empty() const { return records == 0; }
+    int capacity() const { return buf_capacity; }
+    int bytes_used() const { return used; }
+    int max_message_size() const { return buf_capacity - header_size; }
+
+    // Returns the number of records evicted to make room.
+    int push(std::string_view message) {
+        if (static_cast<long>(message.size()) > max_message_size()) {
+            throw std::invalid_argument("Message larger than ring");
+        }
+        int len = static_cast<int>(message.size());
+        int need = header_size + padded(len);
+        int evicted = 0;
+        int pos;
+        while ((pos = place(need)) < 0) {
+            pop();
+            ++evicted;
+        }
+        if (pos != tail) {
+            write_header(tail, skip_marker);
+            used += buf_capacity - tail;
+        }
+        write_header(pos, static_cast<std::uint32_t>(len));
+        std::memcpy(bytes.data() + pos + header_size, message.data(), len);
+        tail = (pos + need) % buf_capacity;
+        used += need;
+        ++records;
+        return evicted;
+    }
+
+    std::string_view front() const {
+        if (empty()) throw std::underflow_error("Ring is empty");
+        return *begin();
+    }
+
+    void pop() {
+        if (empty()) throw std::underflow_error("Ring is empty");
+        int pos = head_record();
+        if (pos != head) used -= buf_capacity - head;
+        int need = header_size + padded(header_at(pos));
+        head = (pos + need) % buf_capacity;
+        used -= need;
+        if (--records == 0) clear();
+    }
+
+    void clear() {
+        head = 0;
+        tail = 0;
+        used = 0;
+        records = 0;
+    }
+
+    const_iterator begin() const { return const_iterator(this, head, records); }
+    const_iterator end() const { return const_iterator(); }
+};
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Placement options for large ring storage. The defaults mean a plain
+// heap allocation.
+struct BufferOptions {
+    bool huge_pages = false;           // transparent huge pages via madvise
+    bool explicit_huge_pages = false;  // MAP_HUGETLB, falls back to THP
+    int numa_node = -1;                // bind pages to this node, -1 = any
+    bool prefault = false;             // touch every page up front
+
+    bool plain() const { return !huge_pages && !explicit_huge_pages && numa_node < 0 && !prefault; }
+
+    bool operator==(const BufferOptions &other) const {
+        return huge_pages == other.huge_pages && explicit_huge_pages == other.explicit_huge_pages &&
+               numa_node == other.numa_node && prefault == other.prefault;
+    }
+};
+
+const std::size_t huge_page_size = 2 * 1024 * 1024;
+
+template <class T>
+class PageAllocator {
+public:
+    typedef T value_type;
+    typedef std::true_type propagate_on_container_copy_assignment;
+    typedef std::true_type propagate_on_container_move_assignment;
+    typedef std::true_type propagate_on_container_swap;
+
+    BufferOptions options;
+
+    PageAllocator() {}
+    explicit PageAllocator(const BufferOptions &opts) : options(opts) {}
+    template <class U>
+    PageAllocator(const PageAllocator<U> &other) : options(other.options) {}
+
+    T *allocate(std::size_t n) {
+        if (options.plain()) return static_cast<T *>(::operator new(n * sizeof(T)));
+#ifdef __linux__
+        std::size_t bytes = mapped_size(n);
+        void *p = MAP_FAILED;
+        if (options.explicit_huge_pages) {
+            p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        }
+        if (p == MAP_FAILED) {
+            p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (p == MAP_FAILED) throw std::bad_alloc();
+            if (options.huge_pages || options.explicit_huge_pages) madvise(p, bytes, MADV_HUGEPAGE);
+        }
+        if (options.numa_node >= 0) bind_to_node(p, bytes);
+        if (options.prefault) {
+            long page = sysconf(_SC_PAGESIZE);
+            for (std::size_t offset = 0; offset < bytes; offset += page) {
+                static_cast<volatile char *>(p)[offset] = 0;
+            }
+        }
+        return static_cast<T *>(p);
+#else
+        return static_cast<T *>(::operator new(n * sizeof(T)));
+#endif
+    }
+
+    void deallocate(T *p, std::size_t n) {
+#ifdef __linux__
+        if (!options.plain()) {
+            munmap(p, mapped_size(n));
+            return;
+        }
+#endif
+        ::operator delete(p);
+    }
+
+private:
+    std::size_t mapped_size(std::size_t n) const {
+        std::size_t bytes = n * sizeof(T);
+        if (options.huge_pages || options.explicit_huge_pages) {
+            bytes = (bytes + huge_page_size - 1) / huge_page_size * huge_page_size;
+        }
+        return bytes == 0 ? 1 : bytes;
+    }
+
+#ifdef __linux__
+    void bind_to_node(void *p, std::size_t bytes) const {
+        const int mpol_bind = 2;
+        const unsigned long max_nodes = sizeof(unsigned long) * 8;
+        if (options.numa_node >= static_cast<int>(max_nodes)) return;
+        unsigned long mask = 1UL << options.numa_node;
+        // Best effort: an unknown node or a kernel without NUMA leaves the
+        // default policy in place.
+        syscall(SYS_mbind, p, bytes, mpol_bind, &mask, max_nodes, 0);
+    }
+#endif
+};
+
+template <class T, class U>
+bool operator==(const PageAllocator<T> &a, const PageAllocator<U> &b) {
+    return a.options == b.options;
+}
+
+template <class T, class U>
+bool operator!=(const PageAllocator<T> &a, const PageAllocator<U> &b) {
+    return !(a == b);
+}
@@ -0,0 +1,209 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+#include "ring_buffer.hpp"
+#include "latency_trace.hpp"
+
+#ifdef __linux__
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
+class ReadyPoller;
+
+// Ring registered with a ReadyPoller. It is queued on the poller's ready
+// list once when its size reaches the watermark, and stays there until a
+// drain leaves it below the watermark again.
+class PolledRing {
+private:
+    friend class ReadyPoller;
+
+    ReadyPoller &poller;
+    CircularBuffer ring;
+    std::mutex lock;
+    int ring_id;
+    int watermark;
+    bool queued;
+    [[no_unique_address]] LatencyTracer tracer;
+
+    PolledRing(ReadyPoller &owner, int id, int capacity, int mark)
+        : poller(owner), ring(capacity), ring_id(id), watermark(mark), queued(false), tracer(capacity) {}
+
+    void signal_if_ready();
+
+public:
+    PolledRing(const PolledRing &) = delete;
+    PolledRing &operator=(const PolledRing &) = delete;
+
+    void push_back(const value_type &item) {
+        std::lock_guard<std::mutex> guard(lock);
+        ring.push_back(item);
+        tracer.pushed();
+        signal_if_ready();
+    }
+
+    void write(const value_type *data, int n) {
+        std::lock_guard<std::mutex> guard(lock);
+        if (n > ring.capacity()) {
+            data += n - ring.capacity();
+            n = ring.capacity();
+        }
+        if (ring.reserve() < n) ring.consume(n - ring.reserve());
+        WriteSpan span = ring.reserve_write(n);
+        std::copy(data, data + span.first_size, span.first);
+        std::copy(data + span.first_size, data + n, span.second);
+        ring.commit_write(n);
+        tracer.pushed(n);
+        signal_if_ready();
+    }
+
+    // Copies up to n oldest elements into out and removes them. Call it
+    // for ids handed out by the poller; a ring still at the watermark is
+    // put back on the ready list.
+    int drain(value_type *out, int n) {
+        std::lock_guard<std::mutex> guard(lock);
+        ReadSpan span = ring.peek_read(n);
+        std::copy(span.first, span.first + span.first_size, out);
+        std::copy(span.second, span.second + span.second_size, out + span.first_size);
+        ring.consume(span.size());
+        tracer.popped(span.size());
+        queued = false;
+        signal_if_ready();
+        return span.size();
+    }
+
+    int size() {
+        std::lock_guard<std::mutex> guard(lock);
+        return ring.size();
+    }
+
+    int id() const { return ring_id; }
+
+#ifdef RING_LATENCY_TRACE
+    const LatencyHistogram &latency() const { return tracer.histogram(); }
+#endif
+};
+
+// Tracks which of many rings have data so consumers touch only the active
+// ones. Waiters block on a condition variable; with_eventfd additionally
+// exposes an eventfd that is readable while the ready list is non-empty,
+// for use with poll/epoll.
+class ReadyPoller {
+private:
+    friend class PolledRing;
+
+    std::deque<std::unique_ptr<PolledRing>> rings;
+    std::mutex lock;
+    std::condition_variable ready_cv;
+    std::deque<int> ready;
+    int event_fd;
+
+    void post(int id) {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            bool was_empty = ready.empty();
+            ready.push_back(id);
+#ifdef __linux__
+            if (was_empty && event_fd >= 0) {
+                std::uint64_t one = 1;
+                ssize_t n = ::write(event_fd, &one, sizeof(one));
+                (void)n;
+            }
+#else
+            (void)was_empty;
+#endif
+        }
+        ready_cv.notify_one();
+    }
+
+    int take(int *ids, int n) {
+        int taken = 0;
+        while (taken < n && !ready.empty()) {
+            ids[taken++] = ready.front();
+            ready.pop_front();
+        }
+#ifdef __linux__
+        if (ready.empty() && event_fd >= 0) {
+            std::uint64_t count;
+            ssize_t r = ::read(event_fd, &count, sizeof(count));
+            (void)r;
+        }
+#endif
+        return taken;
+    }
+
+public:
+    explicit ReadyPoller(bool with_eventfd = false) : event_fd(-1) {
+        if (!with_eventfd) return;
+#ifdef __linux__
+        event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (event_fd < 0) throw std::runtime_error("eventfd failed");
+#else
+        throw std::runtime_error("eventfd is not available");
+#endif
+    }
+
+    ~ReadyPoller() {
+#ifdef __linux__
+        if (event_fd >= 0) close(event_fd);
+#endif
+    }
+
+    ReadyPoller(const ReadyPoller &) = delete;
+    ReadyPoller &operator=(const ReadyPoller &) = delete;
+
+    // Registers a new ring; watermark 1 signals on empty -> non-empty.
+    PolledRing &add_ring(int capacity, int watermark = 1) {
+        if (watermark < 1 || watermark > capacity) throw std::invalid_argument("Watermark must be within capacity");
+        std::lock_guard<std::mutex> guard(lock);
+        int id = static_cast<int>(rings.size());
+        rings.emplace_back(new PolledRing(*this, id, capacity, watermark));
+        return *rings.back();
+    }
+
+    PolledRing &ring(int id) {
+        std::lock_guard<std::mutex> guard(lock);
+        if (id < 0 || id >= static_cast<int>(rings.size())) throw std::out_of_range("Unknown ring id");
+        return *rings[id];
+    }
+
+    // Moves up to n ready ring ids into ids without blocking.
+    int try_wait(int *ids, int n) {
+        std::lock_guard<std::mutex> guard(lock);
+        return take(ids, n);
+    }
+
+    // Blocks until at least one ring is ready or the timeout expires.
+    template <class Rep, class Period>
+    int wait(int *ids, int n, std::chrono::duration<Rep, Period> timeout) {
+        std::unique_lock<std::mutex> guard(lock);
+        ready_cv.wait_for(guard, timeout, [this] { return !ready.empty(); });
+        return take(ids, n);
+    }
+
+    int ready_count() {
+        std::lock_guard<std::mutex> guard(lock);
+        return static_cast<int>(ready.size());
+    }
+
+    int ring_count() {
+        std::lock_guard<std::mutex> guard(lock);
+        return static_cast<int>(rings.size());
+    }
+
+    int fd() const { return event_fd; }
+};
+
+inline void PolledRing::signal_if_ready() {
+    if (queued || ring.size() < watermark) return;
+    queued = true;
+    poller.post(ring_id);
+}
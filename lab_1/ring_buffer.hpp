@@ -1,41 +1,166 @@
+#pragma once
+
 #include <vector>
 #include <stdexcept>
 #include <algorithm>
 #include <iostream>
+#include <cstdint>
+#include <cstring>
+#include "page_allocator.hpp"
 
 typedef char value_type;
 
+// Polynomial rolling hash: H = sum(v(s[i]) * base^i) mod 2^64. The base is
+// odd, so it is invertible and the front element can be removed in O(1).
+const std::uint64_t hash_base = 0x100000001b3ULL;
+
+constexpr std::uint64_t hash_inverse(std::uint64_t b) {
+    std::uint64_t inv = b;
+    for (int i = 0; i < 6; ++i) inv *= 2 - b * inv;
+    return inv;
+}
+
+const std::uint64_t hash_base_inverse = hash_inverse(hash_base);
+
+inline std::uint64_t hash_term(value_type item) {
+    return static_cast<unsigned char>(item) + 1;
+}
+
+struct WriteSpan {
+    value_type *first;
+    int first_size;
+    value_type *second;
+    int second_size;
+
+    int size() const { return first_size + second_size; }
+};
+
+struct ReadSpan {
+    const value_type *first;
+    int first_size;
+    const value_type *second;
+    int second_size;
+
+    int size() const { return first_size + second_size; }
+};
+
 class CircularBuffer {
 
 private:
-    std::vector<value_type> buffer;
+    typedef std::vector<value_type, PageAllocator<value_type>> storage_type;
+
+    storage_type buffer;
     int start, end, count, buf_capacity;
+    bool hashing;
+    mutable bool hash_stale;
+    mutable std::uint64_t hash_value, hash_power;
+
+    void touch() {
+        if (hashing) hash_stale = true;
+    }
+
+    void hash_add_back(value_type item) {
+        hash_value += hash_term(item) * hash_power;
+        hash_power *= hash_base;
+    }
+
+    void hash_remove_front(value_type item) {
+        hash_value = (hash_value - hash_term(item)) * hash_base_inverse;
+        hash_power *= hash_base_inverse;
+    }
+
+    void hash_add_front(value_type item) {
+        hash_value = hash_value * hash_base + hash_term(item);
+        hash_power *= hash_base;
+    }
+
+    void hash_remove_back(value_type item) {
+        hash_power *= hash_base_inverse;
+        hash_value -= hash_term(item) * hash_power;
+    }
+
+    void rehash() const {
+        hash_value = 0;
+        hash_power = 1;
+        for (int i = 0; i < count; ++i) {
+            hash_value += hash_term(buffer[(start + i) % buf_capacity]) * hash_power;
+            hash_power *= hash_base;
+        }
+        hash_stale = false;
+    }
+
+    void copy_live(const CircularBuffer &cb) {
+        ReadSpan live = cb.peek_read(cb.count);
+        std::copy(live.first, live.first + live.first_size, buffer.begin());
+        std::copy(live.second, live.second + live.second_size, buffer.begin() + live.first_size);
+        start = 0;
+        count = cb.count;
+        end = buf_capacity == 0 ? 0 : count % buf_capacity;
+        hashing = cb.hashing;
+        hash_stale = cb.hash_stale;
+        hash_value = cb.hash_value;
+        hash_power = cb.hash_power;
+    }
 
 public:
-    CircularBuffer() : start(0), end(0), count(0), buf_capacity(0) {}
+    // Element handle returned by the non-const accessors. Reading through it
+    // leaves the rolling hash current; only assignment marks it stale.
+    class element_ref {
+    private:
+        CircularBuffer &owner;
+        value_type &item;
+
+    public:
+        element_ref(CircularBuffer &cb, value_type &elem) : owner(cb), item(elem) {}
+
+        operator const value_type &() const { return item; }
+
+        element_ref &operator=(const value_type &value) {
+            owner.touch();
+            item = value;
+            return *this;
+        }
+
+        element_ref &operator=(const element_ref &other) {
+            return *this = static_cast<const value_type &>(other);
+        }
+    };
+
+    CircularBuffer()
+        : start(0), end(0), count(0), buf_capacity(0), hashing(false), hash_stale(true), hash_value(0), hash_power(1) {}
     
     ~CircularBuffer() {}
 
     CircularBuffer(const CircularBuffer &cb)
-        : buffer(cb.buffer), start(cb.start), end(cb.end), count(cb.count), buf_capacity(cb.buf_capacity) {}
+        : buffer(cb.buf_capacity, value_type(), cb.buffer.get_allocator()), start(0), end(0), count(0),
+          buf_capacity(cb.buf_capacity) {
+        copy_live(cb);
+    }
 
     explicit CircularBuffer(int capacity)
-        : buffer(capacity), start(0), end(0), count(0), buf_capacity(capacity) {}
+        : buffer(capacity), start(0), end(0), count(0), buf_capacity(capacity),
+          hashing(false), hash_stale(true), hash_value(0), hash_power(1) {}
+
+    // Large rings can ask for huge pages, a NUMA node and pre-faulting.
+    CircularBuffer(int capacity, const BufferOptions &options)
+        : buffer(capacity, value_type(), PageAllocator<value_type>(options)), start(0), end(0), count(0),
+          buf_capacity(capacity), hashing(false), hash_stale(true), hash_value(0), hash_power(1) {}
 
     CircularBuffer(int capacity, const value_type &elem)
-        : buffer(capacity, elem), start(0), end(0), count(capacity), buf_capacity(capacity) {}
+        : buffer(capacity, elem), start(0), end(0), count(capacity), buf_capacity(capacity),
+          hashing(false), hash_stale(true), hash_value(0), hash_power(1) {}
 
-    value_type &operator[](int i) {
-        return buffer[(start + i) % buf_capacity];
+    element_ref operator[](int i) {
+        return element_ref(*this, buffer[(start + i) % buf_capacity]);
     }
 
     const value_type &operator[](int i) const {
         return buffer[(start + i) % buf_capacity];
     }
 
-    value_type &at(int i) {
+    element_ref at(int i) {
         if (i < 0 || i >= count) throw std::out_of_range("Index out of range");
-        return buffer[(start + i) % buf_capacity];
+        return element_ref(*this, buffer[(start + i) % buf_capacity]);
     }
 
     const value_type &at(int i) const {
@@ -43,16 +168,24 @@ public:
         return buffer[(start + i) % buf_capacity];
     }
 
-    value_type &front() { return buffer[start]; }
-    value_type &back() { return buffer[(end - 1 + buf_capacity) % buf_capacity]; }
+    element_ref front() {
+        return element_ref(*this, buffer[start]);
+    }
+
+    element_ref back() {
+        return element_ref(*this, buffer[(end - 1 + buf_capacity) % buf_capacity]);
+    }
+
     const value_type &front() const { return buffer[start]; }
     const value_type &back() const { return buffer[(end - 1 + buf_capacity) % buf_capacity]; }
 
+    // The returned pointer may be written through, so the hash goes stale.
     value_type* linearize() {
-        if (start <= end) {
-            return &buffer[start];
+        touch();
+        if (is_linearized()) {
+            return buffer.data() + start;
         } else {
-            std::vector<value_type> temp(count);
+            storage_type temp(buf_capacity, value_type(), buffer.get_allocator());
             int j = 0;
             for (int i = start; i < buf_capacity; ++i) {
                 temp[j++] = buffer[i];
@@ -62,17 +195,18 @@ public:
             }
             std::swap(buffer, temp);
             start = 0;
-            end = count;
+            end = count % buf_capacity;
             return &buffer[start];
         }
     }
 
     bool is_linearized() const {
-        return start <= end;
+        return start + count <= buf_capacity;
     }
 
     void rotate(int new_begin) {
         std::rotate(buffer.begin(), buffer.begin() + new_begin, buffer.end());
+        touch();
         start = new_begin;
         end = (start + count) % buf_capacity;
     }
@@ -82,11 +216,13 @@ public:
     bool full() const { return count == buf_capacity; }
     int reserve() const { return buf_capacity - count; }
     int capacity() const { return buf_capacity; }
+    BufferOptions options() const { return buffer.get_allocator().options; }
 
     void set_capacity(int new_capacity) {
         if (new_capacity < count) throw std::invalid_argument("New capacity cannot be less than current size");
         buffer.resize(new_capacity);
         buf_capacity = new_capacity;
+        touch();
     }
 
     void resize(int new_size, const value_type &item = value_type()) {
@@ -99,15 +235,18 @@ public:
         std::fill(buffer.begin() + count, buffer.begin() + new_size, item);
         count = new_size;
         end = (start + count) % buf_capacity;
+        touch();
     }
 
     CircularBuffer &operator=(const CircularBuffer &cb) {
         if (this != &cb) {
-            buffer = cb.buffer;
-            start = cb.start;
-            end = cb.end;
-            count = cb.count;
-            buf_capacity = cb.buf_capacity;
+            // Storage is rebuilt with the source's allocator whenever the
+            // capacity or placement differs, so options follow the copy.
+            if (buf_capacity != cb.buf_capacity || !(options() == cb.options())) {
+                storage_type(cb.buf_capacity, value_type(), cb.buffer.get_allocator()).swap(buffer);
+                buf_capacity = cb.buf_capacity;
+            }
+            copy_live(cb);
         }
         return *this;
     }
@@ -118,9 +257,17 @@ public:
         std::swap(end, cb.end);
         std::swap(count, cb.count);
         std::swap(buf_capacity, cb.buf_capacity);
+        std::swap(hashing, cb.hashing);
+        std::swap(hash_stale, cb.hash_stale);
+        std::swap(hash_value, cb.hash_value);
+        std::swap(hash_power, cb.hash_power);
     }
 
     void push_back(const value_type &item = value_type()) {
+        if (hash_current()) {
+            if (full()) hash_remove_front(buffer[start]);
+            hash_add_back(item);
+        }
         if (full()) {
             start = (start + 1) % buf_capacity;
         }
@@ -130,6 +277,10 @@ public:
     }
 
     void push_front(const value_type &item = value_type()) {
+        if (hash_current()) {
+            if (full()) hash_remove_back(buffer[(end - 1 + buf_capacity) % buf_capacity]);
+            hash_add_front(item);
+        }
         if (full()) {
             end = (end - 1 + buf_capacity) % buf_capacity;
         }
@@ -140,16 +291,52 @@ public:
 
     void pop_back() {
         if (empty()) throw std::underflow_error("Buffer is empty");
+        if (hash_current()) hash_remove_back(buffer[(end - 1 + buf_capacity) % buf_capacity]);
         end = (end - 1 + buf_capacity) % buf_capacity;
         --count;
     }
 
     void pop_front() {
         if (empty()) throw std::underflow_error("Buffer is empty");
+        if (hash_current()) hash_remove_front(buffer[start]);
         start = (start + 1) % buf_capacity;
         --count;
     }
 
+    WriteSpan reserve_write(int n) {
+        if (n < 0) throw std::invalid_argument("Negative reservation size");
+        n = std::min(n, reserve());
+        int first_size = std::min(n, buf_capacity - end);
+        return WriteSpan{buffer.data() + end, first_size, buffer.data(), n - first_size};
+    }
+
+    void commit_write(int k) {
+        if (k < 0 || k > reserve()) throw std::out_of_range("Commit exceeds free space");
+        if (k == 0) return;
+        if (hash_current()) {
+            for (int i = 0; i < k; ++i) hash_add_back(buffer[(end + i) % buf_capacity]);
+        }
+        end = (end + k) % buf_capacity;
+        count += k;
+    }
+
+    ReadSpan peek_read(int n) const {
+        if (n < 0) throw std::invalid_argument("Negative peek size");
+        n = std::min(n, count);
+        int first_size = std::min(n, buf_capacity - start);
+        return ReadSpan{buffer.data() + start, first_size, buffer.data(), n - first_size};
+    }
+
+    void consume(int k) {
+        if (k < 0 || k > count) throw std::out_of_range("Consume exceeds size");
+        if (k == 0) return;
+        if (hash_current()) {
+            for (int i = 0; i < k; ++i) hash_remove_front(buffer[(start + i) % buf_capacity]);
+        }
+        start = (start + k) % buf_capacity;
+        count -= k;
+    }
+
     void insert(int pos, const value_type &item = value_type()) {
         if (pos < 0 || pos >= count) throw std::out_of_range("Index out of range");
         push_back();
@@ -157,6 +344,7 @@ public:
             buffer[(start + i) % buf_capacity] = buffer[(start + i - 1) % buf_capacity];
         }
         buffer[(start + pos) % buf_capacity] = item;    
+        touch();
     }
 
     void erase(int first, int last) {
@@ -166,23 +354,64 @@ public:
         }
         count -= (last - first);
         end = (start + count) % buf_capacity;
+        touch();
     }
 
     void clear() {
         start = 0;
         end = 0;
         count = 0;
+        hash_value = 0;
+        hash_power = 1;
+        hash_stale = false;
+    }
+
+    // With hashing on, every push/pop/overwrite keeps the fingerprint
+    // current; direct element writes only mark it for a lazy rehash.
+    void enable_hash(bool on = true) {
+        hashing = on;
+        if (on) rehash();
+    }
+
+    bool hash_enabled() const { return hashing; }
+
+    bool hash_current() const { return hashing && !hash_stale; }
+
+    std::uint64_t fingerprint() const {
+        if (!hash_current()) rehash();
+        return hash_value;
     }
 };
 
-bool operator==(const CircularBuffer &a, const CircularBuffer &b) {
+inline bool operator==(const CircularBuffer &a, const CircularBuffer &b) {
     if (a.size() != b.size()) return false;
-    for (int i = 0; i < a.size(); ++i) {
-        if (a[i] != b[i]) return false;
+    if (a.hash_current() && b.hash_current() && a.fingerprint() != b.fingerprint()) return false;
+
+    ReadSpan x = a.peek_read(a.size());
+    ReadSpan y = b.peek_read(b.size());
+    const value_type *p = x.first, *q = y.first;
+    int p_left = x.first_size, q_left = y.first_size;
+    int remaining = a.size();
+    while (remaining > 0) {
+        if (p_left == 0) {
+            p = x.second;
+            p_left = x.second_size;
+        }
+        if (q_left == 0) {
+            q = y.second;
+            q_left = y.second_size;
+        }
+        int n = std::min(p_left, q_left);
+        if (std::memcmp(p, q, n) != 0) return false;
+        p += n;
+        q += n;
+        p_left -= n;
+        q_left -= n;
+        remaining -= n;
     }
     return true;
 }
 
-bool operator!=(const CircularBuffer &a, const CircularBuffer &b) {
+inline bool operator!=(const CircularBuffer &a, const CircularBuffer &b) {
     return !(a == b);
 }
\ No newline at end of file
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include "ring_buffer.hpp"
+
+// Single writer, any number of readers. Readers never block the writer:
+// they copy the ring optimistically and retry if the sequence counter
+// moved (odd value = write in progress).
+class SeqlockBuffer {
+private:
+    CircularBuffer ring;
+    std::atomic<unsigned> sequence;
+
+    void begin_write() {
+        sequence.store(sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    void end_write() {
+        sequence.store(sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    bool copy_latest(int k, CircularBuffer &out) const {
+        unsigned before = sequence.load(std::memory_order_acquire);
+        if (before & 1) return false;
+
+        ReadSpan all = ring.peek_read(ring.size());
+        int n = std::min(k, all.size());
+        int skip = all.size() - n;
+
+        out.clear();
+        value_type *dst = out.reserve_write(n).first;
+        int head = std::min(n, std::max(0, all.first_size - skip));
+        // Each segment pointer is offset only when something is copied from
+        // it; otherwise the offset may fall outside the segment.
+        if (head > 0) std::copy(all.first + skip, all.first + skip + head, dst);
+        if (n > head) {
+            const value_type *tail = all.second + (skip + head - all.first_size);
+            std::copy(tail, tail + (n - head), dst + head);
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (sequence.load(std::memory_order_relaxed) != before) return false;
+        out.commit_write(n);
+        return true;
+    }
+
+public:
+    explicit SeqlockBuffer(int capacity) : ring(capacity), sequence(0) {}
+
+    SeqlockBuffer(const SeqlockBuffer &) = delete;
+    SeqlockBuffer &operator=(const SeqlockBuffer &) = delete;
+
+    void push_back(const value_type &item) {
+        begin_write();
+        ring.push_back(item);
+        end_write();
+    }
+
+    void write(const value_type *data, int n) {
+        begin_write();
+        for (int i = 0; i < n; ++i) {
+            ring.push_back(data[i]);
+        }
+        end_write();
+    }
+
+    void pop_front() {
+        // Checked before the write section: a throw inside it would leave
+        // the sequence odd and readers spinning forever.
+        if (ring.empty()) throw std::underflow_error("Buffer is empty");
+        begin_write();
+        ring.pop_front();
+        end_write();
+    }
+
+    void clear() {
+        begin_write();
+        ring.clear();
+        end_write();
+    }
+
+    int capacity() const { return ring.capacity(); }
+
+    // Writer-side access only.
+    const CircularBuffer &buffer() const { return ring; }
+
+    bool try_snapshot(CircularBuffer &out) const {
+        if (out.capacity() < ring.capacity()) out = CircularBuffer(ring.capacity());
+        return copy_latest(ring.capacity(), out);
+    }
+
+    CircularBuffer snapshot() const {
+        CircularBuffer out(ring.capacity());
+        while (!copy_latest(ring.capacity(), out)) {
+            std::this_thread::yield();
+        }
+        return out;
+    }
+
+    CircularBuffer latest(int k) const {
+        if (k < 0) throw std::invalid_argument("Negative snapshot size");
+        CircularBuffer out(std::min(k, ring.capacity()));
+        while (!copy_latest(k, out)) {
+            std::this_thread::yield();
+        }
+        return out;
+    }
+};
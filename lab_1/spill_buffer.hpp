@@ -0,0 +1,162 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "ring_buffer.hpp"
+
+// FIFO that never drops data: when the in-memory ring is full its oldest
+// block is appended to a spill file, and spilled blocks are streamed back
+// one block at a time as the consumer catches up. Order is
+// reload block -> spill file -> ring.
+class SpillingBuffer {
+private:
+    CircularBuffer ring;
+    std::vector<value_type> reload, scratch;
+    int reload_pos;
+    int block_size;
+    std::FILE *file;
+    std::string file_path;
+    long write_offset, read_offset;
+
+    void seek(long offset) {
+        if (std::fseek(file, offset, SEEK_SET) != 0) throw std::runtime_error("Spill file seek failed");
+    }
+
+    void spill() {
+        ReadSpan oldest = ring.peek_read(block_size);
+        seek(write_offset);
+        if (std::fwrite(oldest.first, 1, oldest.first_size, file) != static_cast<size_t>(oldest.first_size) ||
+            std::fwrite(oldest.second, 1, oldest.second_size, file) != static_cast<size_t>(oldest.second_size)) {
+            throw std::runtime_error("Spill file write failed");
+        }
+        write_offset += oldest.size();
+        ring.consume(oldest.size());
+    }
+
+    bool refill() {
+        if (reload_pos < static_cast<int>(reload.size())) return true;
+        if (read_offset == write_offset) {
+            read_offset = write_offset = 0;
+            return false;
+        }
+        int n = static_cast<int>(std::min<long>(block_size, write_offset - read_offset));
+        reload.resize(n);
+        seek(read_offset);
+        if (std::fread(reload.data(), 1, n, file) != static_cast<size_t>(n)) {
+            throw std::runtime_error("Spill file read failed");
+        }
+        read_offset += n;
+        reload_pos = 0;
+        if (read_offset > write_offset / 2) compact();
+        return true;
+    }
+
+    // Moves the unread tail of the spill file to its start. Runs once more
+    // than half the file has been read, so the copy costs less than the
+    // reads since the previous compaction and the file stays within twice
+    // its live size even if it never fully drains.
+    void compact() {
+        long live = write_offset - read_offset;
+        for (long done = 0; done < live;) {
+            int n = static_cast<int>(std::min<long>(block_size, live - done));
+            scratch.resize(n);
+            seek(read_offset + done);
+            if (std::fread(scratch.data(), 1, n, file) != static_cast<size_t>(n)) {
+                throw std::runtime_error("Spill file read failed");
+            }
+            seek(done);
+            if (std::fwrite(scratch.data(), 1, n, file) != static_cast<size_t>(n)) {
+                throw std::runtime_error("Spill file write failed");
+            }
+            done += n;
+        }
+        read_offset = 0;
+        write_offset = live;
+    }
+
+public:
+    // An empty path spills to an anonymous temporary file. A named spill
+    // file is scratch space and is removed on destruction.
+    SpillingBuffer(int capacity, int block, const std::string &path = "")
+        : ring(capacity), reload_pos(0), block_size(block), file(nullptr), file_path(path),
+          write_offset(0), read_offset(0) {
+        if (capacity < 1) throw std::invalid_argument("Capacity must be positive");
+        if (block < 1 || block > capacity) throw std::invalid_argument("Block size must be within capacity");
+        file = path.empty() ? std::tmpfile() : std::fopen(path.c_str(), "w+b");
+        if (!file) throw std::runtime_error("Cannot open spill file");
+        reload.reserve(block);
+        scratch.reserve(block);
+    }
+
+    ~SpillingBuffer() {
+        std::fclose(file);
+        if (!file_path.empty()) std::remove(file_path.c_str());
+    }
+
+    SpillingBuffer(const SpillingBuffer &) = delete;
+    SpillingBuffer &operator=(const SpillingBuffer &) = delete;
+
+    void push_back(const value_type &item) {
+        if (ring.full()) spill();
+        ring.push_back(item);
+    }
+
+    void write(const value_type *data, int n) {
+        while (n > 0) {
+            if (ring.full()) spill();
+            WriteSpan span = ring.reserve_write(n);
+            std::copy(data, data + span.first_size, span.first);
+            std::copy(data + span.first_size, data + span.size(), span.second);
+            ring.commit_write(span.size());
+            data += span.size();
+            n -= span.size();
+        }
+    }
+
+    value_type front() {
+        if (refill()) return reload[reload_pos];
+        if (ring.empty()) throw std::underflow_error("Buffer is empty");
+        return ring.front();
+    }
+
+    void pop_front() {
+        if (refill()) {
+            ++reload_pos;
+            return;
+        }
+        ring.pop_front();
+    }
+
+    // Copies up to n oldest elements into out and removes them.
+    int read(value_type *out, int n) {
+        int done = 0;
+        while (done < n && refill()) {
+            int k = std::min(n - done, static_cast<int>(reload.size()) - reload_pos);
+            std::copy(reload.begin() + reload_pos, reload.begin() + reload_pos + k, out + done);
+            reload_pos += k;
+            done += k;
+        }
+        if (done < n) {
+            ReadSpan span = ring.peek_read(n - done);
+            std::copy(span.first, span.first + span.first_size, out + done);
+            std::copy(span.second, span.second + span.second_size, out + done + span.first_size);
+            ring.consume(span.size());
+            done += span.size();
+        }
+        return done;
+    }
+
+    long size() const {
+        return (static_cast<long>(reload.size()) - reload_pos) + (write_offset - read_offset) + ring.size();
+    }
+
+    bool empty() const { return size() == 0; }
+
+    // Elements currently held on disk.
+    long spilled() const { return write_offset - read_offset; }
+
+    int capacity() const { return ring.capacity(); }
+};
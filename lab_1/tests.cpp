@@ -1,5 +1,27 @@
 #include "gtest/gtest.h"
+#include <atomic>
+#include <cstdio>
+#include <filesystem>
+#include <future>
+#include <thread>
+#include <vector>
+#ifdef __linux__
+#include <poll.h>
+#endif
+#include <string>
 #include "ring_buffer.hpp"
+#include "async_channel.hpp"
+#include "snapshot_buffer.hpp"
+#include "cow_buffer.hpp"
+#include "message_ring.hpp"
+#include "spill_buffer.hpp"
+#include "disk_flusher.hpp"
+#include "compressed_log.hpp"
+#include "combining_buffer.hpp"
+#include "ready_poller.hpp"
+#include "latency_trace.hpp"
+#include "perf_harness.hpp"
+#include "work_stealing.hpp"
 
 TEST(CircularBufferTests, Initialization) {
     CircularBuffer buffer(5);
@@ -224,6 +246,790 @@ TEST(CircularBufferTests, AssignmentOperator) {
     EXPECT_EQ(buffer2[2], 'c');
 }
 
+TEST(CircularBufferTests, ReserveCommitWrite) {
+    CircularBuffer buffer(5);
+    buffer.push_back('a');
+    buffer.push_back('b');
+    buffer.push_back('c');
+    buffer.pop_front();
+    buffer.pop_front();
+
+    WriteSpan span = buffer.reserve_write(4);
+    EXPECT_EQ(span.size(), 4);
+    EXPECT_EQ(span.first_size, 2);
+    EXPECT_EQ(span.second_size, 2);
+
+    const char data[] = "wxyz";
+    std::copy(data, data + span.first_size, span.first);
+    std::copy(data + span.first_size, data + span.size(), span.second);
+    EXPECT_EQ(buffer.size(), 1);
+
+    buffer.commit_write(3);
+
+    EXPECT_EQ(buffer.size(), 4);
+    EXPECT_EQ(buffer[0], 'c');
+    EXPECT_EQ(buffer[1], 'w');
+    EXPECT_EQ(buffer[2], 'x');
+    EXPECT_EQ(buffer[3], 'y');
+    EXPECT_EQ(buffer.reserve_write(10).size(), 1);
+    EXPECT_THROW(buffer.commit_write(2), std::out_of_range);
+}
+
+TEST(CircularBufferTests, PeekConsume) {
+    CircularBuffer buffer(4);
+    buffer.push_back('a');
+    buffer.push_back('b');
+    buffer.push_back('c');
+    buffer.push_back('d');
+    buffer.push_back('e');
+
+    ReadSpan span = buffer.peek_read(10);
+    EXPECT_EQ(span.size(), 4);
+    EXPECT_EQ(std::string(span.first, span.first_size), "bcd");
+    EXPECT_EQ(std::string(span.second, span.second_size), "e");
+
+    buffer.consume(3);
+
+    EXPECT_EQ(buffer.size(), 1);
+    EXPECT_EQ(buffer.front(), 'e');
+    EXPECT_THROW(buffer.consume(2), std::out_of_range);
+}
+
+static Task produce_letters(AsyncChannel &channel, int n, std::promise<void> *done) {
+    for (int i = 0; i < n; ++i) {
+        co_await channel.push(static_cast<value_type>('a' + i));
+    }
+    channel.close();
+    if (done) done->set_value();
+}
+
+static Task collect_letters(AsyncChannel &channel, std::string &out, std::promise<void> *done) {
+    while (std::optional<value_type> item = co_await channel.pop()) {
+        out.push_back(*item);
+    }
+    if (done) done->set_value();
+}
+
+TEST(AsyncChannelTests, InlinePipeline) {
+    InlineExecutor executor;
+    AsyncChannel channel(2, executor);
+    std::string out;
+
+    collect_letters(channel, out, nullptr).start(executor);
+    produce_letters(channel, 10, nullptr).start(executor);
+    executor.run();
+
+    EXPECT_EQ(out, "abcdefghij");
+    EXPECT_EQ(channel.size(), 0);
+}
+
+TEST(AsyncChannelTests, PopAfterClose) {
+    InlineExecutor executor;
+    AsyncChannel channel(4, executor);
+    std::string out;
+
+    produce_letters(channel, 3, nullptr).start(executor);
+    executor.run();
+    EXPECT_EQ(channel.size(), 3);
+
+    collect_letters(channel, out, nullptr).start(executor);
+    executor.run();
+
+    EXPECT_EQ(out, "abc");
+}
+
+TEST(AsyncChannelTests, ThreadPoolPipeline) {
+    ThreadPoolExecutor executor(2);
+    AsyncChannel channel(3, executor);
+    std::string out;
+    std::promise<void> produced, collected;
+
+    collect_letters(channel, out, &collected).start(executor);
+    produce_letters(channel, 26, &produced).start(executor);
+    produced.get_future().wait();
+    collected.get_future().wait();
+
+    EXPECT_EQ(out, "abcdefghijklmnopqrstuvwxyz");
+}
+
+TEST(SeqlockBufferTests, SnapshotAndLatest) {
+    SeqlockBuffer buffer(4);
+    const char data[] = "abcdef";
+    buffer.write(data, 6);
+
+    CircularBuffer snapshot = buffer.snapshot();
+    EXPECT_EQ(snapshot.size(), 4);
+    EXPECT_EQ(snapshot[0], 'c');
+    EXPECT_EQ(snapshot[3], 'f');
+
+    CircularBuffer latest = buffer.latest(2);
+    EXPECT_EQ(latest.size(), 2);
+    EXPECT_EQ(latest[0], 'e');
+    EXPECT_EQ(latest[1], 'f');
+}
+
+TEST(SeqlockBufferTests, PopEmptyLeavesReadersWorking) {
+    SeqlockBuffer buffer(4);
+    EXPECT_THROW(buffer.pop_front(), std::underflow_error);
+
+    CircularBuffer snapshot = buffer.snapshot();
+    EXPECT_TRUE(snapshot.empty());
+
+    buffer.push_back('a');
+    CircularBuffer latest = buffer.latest(1);
+    ASSERT_EQ(latest.size(), 1);
+    EXPECT_EQ(latest[0], 'a');
+}
+
+TEST(SeqlockBufferTests, ConcurrentWriterNeverTearsSnapshot) {
+    SeqlockBuffer buffer(64);
+    std::atomic<bool> stop(false);
+
+    std::thread writer([&] {
+        unsigned char next = 0;
+        while (!stop.load()) {
+            buffer.push_back(static_cast<value_type>(next++));
+        }
+    });
+
+    for (int round = 0; round < 2000; ++round) {
+        CircularBuffer snapshot = buffer.latest(16);
+        for (int i = 1; i < snapshot.size(); ++i) {
+            ASSERT_EQ(static_cast<unsigned char>(snapshot[i]),
+                      static_cast<unsigned char>(snapshot[i - 1] + 1));
+        }
+    }
+    stop.store(true);
+    writer.join();
+}
+
+TEST(CircularBufferTests, CopyWrappedBuffer) {
+    CircularBuffer buffer(4);
+    buffer.push_back('a');
+    buffer.push_back('b');
+    buffer.push_back('c');
+    buffer.push_back('d');
+    buffer.push_back('e');
+
+    CircularBuffer copy(buffer);
+    EXPECT_TRUE(copy.is_linearized());
+    EXPECT_EQ(copy.capacity(), 4);
+    EXPECT_TRUE(copy == buffer);
+
+    CircularBuffer assigned(2);
+    assigned = buffer;
+    EXPECT_EQ(assigned.capacity(), 4);
+    EXPECT_EQ(assigned[0], 'b');
+    EXPECT_EQ(assigned[3], 'e');
+    assigned.push_back('f');
+    EXPECT_EQ(assigned.front(), 'c');
+    EXPECT_EQ(assigned.back(), 'f');
+}
+
+TEST(CowCircularBufferTests, SnapshotSharesUntilWrite) {
+    CowCircularBuffer buffer(8, 4);
+    for (char c = 'a'; c < 'a' + 6; ++c) {
+        buffer.push_back(c);
+    }
+
+    CowSnapshot snapshot = buffer.snapshot();
+    EXPECT_EQ(buffer.shared_chunks(), 2);
+
+    buffer.push_back('g');
+    EXPECT_EQ(buffer.shared_chunks(), 1);
+    buffer[0] = 'z';
+    EXPECT_EQ(buffer.shared_chunks(), 0);
+
+    EXPECT_EQ(snapshot.size(), 6);
+    EXPECT_EQ(snapshot[0], 'a');
+    EXPECT_EQ(snapshot[5], 'f');
+    EXPECT_THROW(snapshot.at(6), std::out_of_range);
+    EXPECT_EQ(buffer[0], 'z');
+    EXPECT_EQ(buffer.back(), 'g');
+}
+
+TEST(CowCircularBufferTests, OverwriteKeepsSnapshotIntact) {
+    CowCircularBuffer buffer(4, 2);
+    for (char c = 'a'; c < 'a' + 4; ++c) {
+        buffer.push_back(c);
+    }
+    CowSnapshot snapshot = buffer.snapshot();
+
+    buffer.push_back('e');
+    buffer.push_back('f');
+
+    EXPECT_EQ(buffer.front(), 'c');
+    EXPECT_EQ(buffer[3], 'f');
+    EXPECT_EQ(snapshot[0], 'a');
+    EXPECT_EQ(snapshot[3], 'd');
+}
+
+TEST(CowCircularBufferTests, SnapshotReleasedOnAnotherThread) {
+    CowCircularBuffer buffer(8, 4);
+    for (char c = 'a'; c < 'a' + 8; ++c) {
+        buffer.push_back(c);
+    }
+    CowSnapshot snapshot = buffer.snapshot();
+    CowSnapshot copy = snapshot;
+    EXPECT_EQ(buffer.shared_chunks(), 2);
+
+    std::thread([moved = std::move(snapshot)] { EXPECT_EQ(moved[7], 'h'); }).join();
+    EXPECT_EQ(buffer.shared_chunks(), 2);
+    std::thread([moved = std::move(copy)] { EXPECT_EQ(moved[0], 'a'); }).join();
+    EXPECT_EQ(buffer.shared_chunks(), 0);
+
+    buffer[0] = 'z';
+    EXPECT_EQ(buffer[0], 'z');
+    EXPECT_EQ(buffer.shared_chunks(), 0);
+}
+
+TEST(MessageRingTests, PushPopInOrder) {
+    MessageRing ring(64);
+    ring.push("hello");
+    ring.push("");
+    ring.push("world!");
+
+    EXPECT_EQ(ring.size(), 3);
+    EXPECT_EQ(ring.front(), "hello");
+    ring.pop();
+    EXPECT_EQ(ring.front(), "");
+    ring.pop();
+    EXPECT_EQ(ring.front(), "world!");
+    ring.pop();
+    EXPECT_TRUE(ring.empty());
+    EXPECT_EQ(ring.bytes_used(), 0);
+    EXPECT_THROW(ring.pop(), std::underflow_error);
+}
+
+TEST(MessageRingTests, EvictsWholeRecordsAcrossWrap) {
+    MessageRing ring(32);
+    ring.push("aaaaaaaa");
+    ring.push("bbbbbbbb");
+    ring.pop();
+
+    EXPECT_EQ(ring.push("cccccccc"), 0);
+    EXPECT_EQ(ring.push("dd"), 1);
+
+    std::vector<std::string> contents(ring.begin(), ring.end());
+    ASSERT_EQ(contents.size(), 2u);
+    EXPECT_EQ(contents[0], "cccccccc");
+    EXPECT_EQ(contents[1], "dd");
+    EXPECT_THROW(ring.push(std::string(40, 'x')), std::invalid_argument);
+}
+
+TEST(MessageRingTests, KeepsNewestSuffix) {
+    MessageRing ring(100);
+    std::vector<std::string> pushed;
+    for (int i = 0; i < 500; ++i) {
+        std::string message(static_cast<size_t>((i * 7) % 23), static_cast<char>('a' + i % 26));
+        ring.push(message);
+        pushed.push_back(message);
+
+        ASSERT_LE(ring.bytes_used(), ring.capacity());
+        std::vector<std::string> contents(ring.begin(), ring.end());
+        ASSERT_EQ(static_cast<int>(contents.size()), ring.size());
+        for (size_t j = 0; j < contents.size(); ++j) {
+            ASSERT_EQ(contents[j], pushed[pushed.size() - contents.size() + j]);
+        }
+    }
+}
+
+TEST(CircularBufferTests, RollingHashTracksContents) {
+    CircularBuffer hashed(8);
+    hashed.enable_hash();
+    for (int i = 0; i < 50; ++i) {
+        hashed.push_back(static_cast<value_type>('a' + i % 26));
+        if (i % 3 == 0) hashed.pop_front();
+        if (i % 5 == 0) hashed.push_front('x');
+        if (i % 7 == 0) hashed.pop_back();
+        ASSERT_TRUE(hashed.hash_current());
+
+        CircularBuffer plain(hashed);
+        plain.enable_hash(false);
+        ASSERT_EQ(hashed.fingerprint(), plain.fingerprint());
+    }
+
+    value_type first = hashed[0];
+    EXPECT_EQ(hashed.front(), first);
+    EXPECT_EQ(hashed.at(1), hashed[1]);
+    EXPECT_TRUE(hashed.hash_current());
+
+    hashed[0] = 'z';
+    EXPECT_FALSE(hashed.hash_current());
+    std::uint64_t rehashed = hashed.fingerprint();
+    EXPECT_TRUE(hashed.hash_current());
+    EXPECT_EQ(rehashed, CircularBuffer(hashed).fingerprint());
+}
+
+TEST(CircularBufferTests, RollingHashComparison) {
+    CircularBuffer a(5), b(5);
+    a.enable_hash();
+    b.enable_hash();
+    for (char c : std::string("abcdefg")) a.push_back(c);
+    for (char c : std::string("cdefg")) b.push_back(c);
+
+    EXPECT_FALSE(a.is_linearized());
+    EXPECT_TRUE(b.is_linearized());
+    EXPECT_EQ(a.fingerprint(), b.fingerprint());
+    EXPECT_TRUE(a == b);
+
+    b.pop_back();
+    b.push_back('h');
+    EXPECT_NE(a.fingerprint(), b.fingerprint());
+    EXPECT_TRUE(a != b);
+}
+
+TEST(SpillingBufferTests, KeepsEverythingInOrder) {
+    SpillingBuffer buffer(64, 16);
+    for (int i = 0; i < 10000; ++i) {
+        buffer.push_back(static_cast<value_type>(i % 128));
+    }
+    EXPECT_EQ(buffer.size(), 10000);
+    EXPECT_GT(buffer.spilled(), 0);
+
+    for (int i = 0; i < 10000; ++i) {
+        ASSERT_EQ(buffer.front(), static_cast<value_type>(i % 128));
+        buffer.pop_front();
+    }
+    EXPECT_TRUE(buffer.empty());
+    EXPECT_THROW(buffer.front(), std::underflow_error);
+}
+
+TEST(SpillingBufferTests, InterleavedBulkReadWrite) {
+    SpillingBuffer buffer(32, 8);
+    std::string written, read;
+    char chunk[50];
+    for (int round = 0; round < 200; ++round) {
+        for (int i = 0; i < 37; ++i) {
+            chunk[i] = static_cast<char>('a' + (written.size() + i) % 26);
+        }
+        buffer.write(chunk, 37);
+        written.append(chunk, 37);
+
+        int n = buffer.read(chunk, round % 2 ? 50 : 20);
+        read.append(chunk, n);
+    }
+    while (!buffer.empty()) {
+        int n = buffer.read(chunk, 50);
+        read.append(chunk, n);
+    }
+    EXPECT_EQ(read, written);
+}
+
+TEST(SpillingBufferTests, SustainedOverflowKeepsFileBounded) {
+    std::string path = (std::filesystem::temp_directory_path() / "spill_buffer_test.bin").string();
+    SpillingBuffer buffer(64, 16, path);
+    for (int i = 0; i < 300; ++i) {
+        buffer.push_back(static_cast<value_type>(i % 128));
+    }
+
+    // Backlog stays around 300 elements, so the file never fully drains.
+    int next = 0;
+    for (int i = 300; i < 100000; ++i) {
+        buffer.push_back(static_cast<value_type>(i % 128));
+        ASSERT_EQ(buffer.front(), static_cast<value_type>(next++ % 128));
+        buffer.pop_front();
+        ASSERT_GT(buffer.spilled(), 0);
+    }
+    EXPECT_LT(std::filesystem::file_size(path), 4096u);
+
+    while (!buffer.empty()) {
+        ASSERT_EQ(buffer.front(), static_cast<value_type>(next++ % 128));
+        buffer.pop_front();
+    }
+    EXPECT_EQ(next, 100000);
+}
+
+static void flush_pattern(DiskFlusher::Mode mode, bool *used_io_uring) {
+    std::FILE *file = std::tmpfile();
+    int fd = fileno(file);
+    std::string expected;
+    {
+        DiskFlusher flusher(fd, 4096, 1024, 3, 0, mode);
+        *used_io_uring = flusher.uses_io_uring();
+        char chunk[777];
+        for (int round = 0; round < 100; ++round) {
+            for (int i = 0; i < 777; ++i) {
+                chunk[i] = static_cast<char>('a' + (round + i) % 26);
+            }
+            flusher.write(chunk, 777);
+            expected.append(chunk, 777);
+            EXPECT_LE(flusher.writes_in_flight(), 3);
+        }
+        flusher.flush();
+        EXPECT_EQ(flusher.pending(), 0);
+    }
+    std::string actual(expected.size(), '\0');
+    EXPECT_EQ(pread(fd, &actual[0], actual.size(), 0), static_cast<ssize_t>(actual.size()));
+    std::fclose(file);
+    EXPECT_TRUE(actual == expected);
+}
+
+TEST(DiskFlusherTests, ThreadedBackendWritesEverything) {
+    bool used_io_uring = true;
+    flush_pattern(DiskFlusher::threaded, &used_io_uring);
+    EXPECT_FALSE(used_io_uring);
+}
+
+TEST(DiskFlusherTests, AutomaticBackendWritesEverything) {
+    bool used_io_uring = false;
+    flush_pattern(DiskFlusher::automatic, &used_io_uring);
+    RecordProperty("backend", used_io_uring ? "io_uring" : "thread");
+}
+
+TEST(CircularBufferTests, HugePageOptions) {
+    BufferOptions options;
+    options.huge_pages = true;
+    options.numa_node = 0;
+    options.prefault = true;
+    CircularBuffer buffer(3 * 1024 * 1024, options);
+
+    for (int i = 0; i < buffer.capacity() + 10; ++i) {
+        buffer.push_back(static_cast<value_type>(i % 100));
+    }
+    EXPECT_TRUE(buffer.full());
+    EXPECT_EQ(buffer.front(), static_cast<value_type>(10 % 100));
+
+    buffer.linearize();
+    CircularBuffer copy(buffer);
+    EXPECT_TRUE(copy.options() == options);
+    EXPECT_TRUE(copy == buffer);
+    EXPECT_TRUE(CircularBuffer(4).options().plain());
+}
+
+TEST(CircularBufferTests, AssignmentCopiesOptions) {
+    BufferOptions options;
+    options.huge_pages = true;
+    CircularBuffer placed(16, options);
+    placed.push_back('a');
+
+    CircularBuffer plain(16);
+    plain = placed;
+    EXPECT_TRUE(plain.options() == options);
+    EXPECT_TRUE(plain == placed);
+
+    placed = CircularBuffer(8);
+    EXPECT_TRUE(placed.options().plain());
+    EXPECT_EQ(placed.capacity(), 8);
+}
+
+TEST(CompressedLogTests, CodecRoundTrip) {
+    std::string text;
+    for (int i = 0; i < 2000; ++i) {
+        text += "INFO request id=" + std::to_string(i % 37) + " served in " + std::to_string(i % 5) + "ms\n";
+    }
+    text += std::string(300, 'x') + "tail";
+
+    std::vector<char> packed;
+    lz_compress(text.data(), static_cast<int>(text.size()), packed);
+    EXPECT_LT(packed.size(), text.size() / 3);
+
+    std::string restored(text.size(), '\0');
+    int n = lz_decompress(packed.data(), static_cast<int>(packed.size()), &restored[0], static_cast<int>(restored.size()));
+    EXPECT_EQ(n, static_cast<int>(text.size()));
+    EXPECT_TRUE(restored == text);
+
+    packed.resize(packed.size() / 2);
+    EXPECT_THROW(lz_decompress(packed.data(), static_cast<int>(packed.size()), &restored[0], 10), std::runtime_error);
+}
+
+TEST(CompressedLogTests, EvictsWholeBlocksAndSearches) {
+    CompressedLog log(4096, 1024);
+    std::string all;
+    for (int i = 0; i < 3000; ++i) {
+        std::string line = "line " + std::to_string(i) + " status=ok\n";
+        log.append(line);
+        all += line;
+    }
+
+    EXPECT_GT(log.sealed_blocks(), 0);
+    EXPECT_LE(log.stored_bytes(), log.capacity() + 1024);
+    std::string kept = log.text();
+    EXPECT_EQ(static_cast<long>(kept.size()), log.size());
+    EXPECT_LT(kept.size(), all.size());
+    EXPECT_EQ(all.compare(all.size() - kept.size(), kept.size(), kept), 0);
+    EXPECT_EQ(kept.size() % 1024, all.size() % 1024);
+
+    EXPECT_EQ(log.find("line 2999 status"), static_cast<long>(kept.find("line 2999 status")));
+    EXPECT_EQ(log.find("line 1 status"), -1);
+}
+
+TEST(CombiningBufferTests, BatchesPublishInOrder) {
+    CombiningBuffer shared(16, 4);
+    char out[16];
+    {
+        CombiningBuffer::Producer producer(shared);
+        for (char c = 'a'; c < 'g'; ++c) producer.push(c);
+        EXPECT_EQ(shared.size(), 4);
+        EXPECT_EQ(producer.staged(), 2);
+        EXPECT_EQ(shared.pop(out, 3), 3);
+        EXPECT_EQ(std::string(out, 3), "abc");
+    }
+    EXPECT_EQ(shared.pop(out, 16), 3);
+    EXPECT_EQ(std::string(out, 3), "def");
+    EXPECT_THROW(CombiningBuffer(4, 5), std::invalid_argument);
+}
+
+TEST(CombiningBufferTests, FullRingDropsOldest) {
+    CombiningBuffer shared(6, 4);
+    CombiningBuffer::Producer producer(shared);
+    for (char c = 'a'; c < 'k'; ++c) producer.push(c);
+    producer.flush();
+    char out[6];
+    EXPECT_EQ(shared.pop(out, 6), 6);
+    EXPECT_EQ(std::string(out, 6), "efghij");
+}
+
+TEST(CombiningBufferTests, TimeoutFlushesPartialBatch) {
+    CombiningBuffer shared(64, 32, std::chrono::milliseconds(1));
+    CombiningBuffer::Producer producer(shared);
+    producer.push('a');
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    producer.push('b');
+    EXPECT_EQ(producer.staged(), 0);
+    EXPECT_EQ(shared.size(), 2);
+}
+
+TEST(CombiningBufferTests, PopFlushesIdleProducer) {
+    CombiningBuffer shared(64, 32, std::chrono::milliseconds(50));
+    CombiningBuffer::Producer producer(shared);
+    producer.push('a');
+    producer.push('b');
+    char out[4];
+    EXPECT_EQ(shared.pop(out, 4), 0);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    ASSERT_EQ(shared.pop(out, 4), 2);
+    EXPECT_EQ(std::string(out, 2), "ab");
+    EXPECT_EQ(producer.staged(), 0);
+}
+
+TEST(CombiningBufferTests, ConcurrentProducersKeepPerThreadOrder) {
+    const int threads = 8, per_thread = 5000;
+    CombiningBuffer shared(threads * per_thread, 64);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&shared, t] {
+            CombiningBuffer::Producer producer(shared);
+            for (int i = 0; i < per_thread; ++i) producer.push(static_cast<char>(t * 16 + i % 16));
+        });
+    }
+    for (std::thread &worker : workers) worker.join();
+
+    std::vector<char> out(threads * per_thread);
+    EXPECT_EQ(shared.pop(out.data(), static_cast<int>(out.size())), threads * per_thread);
+    std::vector<int> seen(threads, 0);
+    for (char c : out) {
+        int t = c / 16;
+        EXPECT_EQ(c % 16, seen[t] % 16);
+        ++seen[t];
+    }
+    for (int count : seen) EXPECT_EQ(count, per_thread);
+}
+
+TEST(ReadyPollerTests, ReportsOnlyActiveRings) {
+    ReadyPoller poller;
+    for (int i = 0; i < 1000; ++i) poller.add_ring(8);
+    int ids[16];
+    EXPECT_EQ(poller.try_wait(ids, 16), 0);
+
+    poller.ring(7).push_back('a');
+    poller.ring(7).push_back('b');
+    poller.ring(900).write("xyz", 3);
+    EXPECT_EQ(poller.ready_count(), 2);
+    EXPECT_EQ(poller.wait(ids, 16, std::chrono::milliseconds(10)), 2);
+    EXPECT_EQ(ids[0], 7);
+    EXPECT_EQ(ids[1], 900);
+
+    char out[8];
+    EXPECT_EQ(poller.ring(7).drain(out, 1), 1);
+    EXPECT_EQ(out[0], 'a');
+    EXPECT_EQ(poller.try_wait(ids, 16), 1);
+    EXPECT_EQ(ids[0], 7);
+    EXPECT_EQ(poller.ring(7).drain(out, 8), 1);
+    EXPECT_EQ(poller.ring(900).drain(out, 8), 3);
+    EXPECT_EQ(poller.ready_count(), 0);
+    EXPECT_EQ(poller.wait(ids, 16, std::chrono::milliseconds(1)), 0);
+}
+
+TEST(ReadyPollerTests, WatermarkAndEventfd) {
+    ReadyPoller poller(true);
+    PolledRing &ring = poller.add_ring(16, 4);
+    EXPECT_THROW(poller.add_ring(4, 5), std::invalid_argument);
+    ring.write("abc", 3);
+    EXPECT_EQ(poller.ready_count(), 0);
+#ifdef __linux__
+    pollfd pfd = {poller.fd(), POLLIN, 0};
+    EXPECT_EQ(::poll(&pfd, 1, 0), 0);
+    ring.push_back('d');
+    EXPECT_EQ(::poll(&pfd, 1, 0), 1);
+    int ids[4];
+    EXPECT_EQ(poller.try_wait(ids, 4), 1);
+    EXPECT_EQ(::poll(&pfd, 1, 0), 0);
+#endif
+}
+
+TEST(ReadyPollerTests, ConsumerThreadSeesEveryElement) {
+    const int streams = 256, per_stream = 200;
+    ReadyPoller poller;
+    for (int i = 0; i < streams; ++i) poller.add_ring(64);
+    std::atomic<long> received(0);
+    std::thread consumer([&] {
+        int ids[32];
+        char out[64];
+        while (received.load() < static_cast<long>(streams) * per_stream) {
+            int n = poller.wait(ids, 32, std::chrono::milliseconds(5));
+            for (int i = 0; i < n; ++i) received += poller.ring(ids[i]).drain(out, 64);
+        }
+    });
+    for (int k = 0; k < per_stream; ++k) {
+        for (int i = 0; i < streams; ++i) {
+            PolledRing &ring = poller.ring(i);
+            while (ring.size() == 64) std::this_thread::yield();
+            ring.push_back('x');
+        }
+    }
+    consumer.join();
+    EXPECT_EQ(received.load(), static_cast<long>(streams) * per_stream);
+}
+
+TEST(LatencyTraceTests, HistogramPercentiles) {
+    LatencyHistogram histogram;
+    EXPECT_EQ(histogram.percentile_ticks(50), 0u);
+    for (std::uint64_t v = 1; v <= 1000; ++v) histogram.record(v);
+    histogram.record(1ULL << 40);
+    EXPECT_EQ(histogram.count(), 1001u);
+    EXPECT_EQ(histogram.percentile_ticks(0), 1u);
+    std::uint64_t median = histogram.percentile_ticks(50);
+    EXPECT_LE(median, 500u);
+    EXPECT_GE(median, 500u - 500u / 16);
+    std::uint64_t p99 = histogram.percentile_ticks(99);
+    EXPECT_LE(p99, 990u);
+    EXPECT_GE(p99, 990u - 990u / 16);
+    EXPECT_EQ(histogram.percentile_ticks(100), 1ULL << 40);
+    histogram.reset();
+    EXPECT_EQ(histogram.count(), 0u);
+}
+
+#ifdef RING_LATENCY_TRACE
+TEST(LatencyTraceTests, QueuesRecordDwellTime) {
+    ReadyPoller poller;
+    PolledRing &ring = poller.add_ring(4);
+    ring.write("abcdef", 6);
+    char out[4];
+    EXPECT_EQ(ring.drain(out, 3), 3);
+    EXPECT_EQ(ring.latency().count(), 3u);
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    EXPECT_EQ(ring.drain(out, 4), 1);
+    EXPECT_EQ(ring.latency().count(), 4u);
+    EXPECT_GE(ring.latency().max_ns(), 1e6);
+
+    CombiningBuffer shared(16, 2);
+    {
+        CombiningBuffer::Producer producer(shared);
+        producer.push('x');
+        producer.push('y');
+    }
+    EXPECT_EQ(shared.pop(out, 4), 2);
+    EXPECT_EQ(shared.latency().count(), 2u);
+
+    InlineExecutor executor;
+    AsyncChannel channel(2, executor);
+    std::string letters;
+    collect_letters(channel, letters, nullptr).start(executor);
+    produce_letters(channel, 10, nullptr).start(executor);
+    executor.run();
+    EXPECT_EQ(channel.latency().count(), 10u);
+}
+#endif
+
+TEST(PerfHarnessTests, JsonBaselineRoundTrip) {
+    PerfHarness harness;
+    long sum = 0;
+    harness.measure("loop \"sum\"", 1000, [&sum] {
+        for (int i = 0; i < 1000; ++i) sum += i;
+    });
+    harness.record("external", 500.0, 10);
+    EXPECT_EQ(sum, 499500);
+
+    std::vector<PerfSample> parsed = PerfHarness::parse_json(harness.to_json());
+    ASSERT_EQ(parsed.size(), 2u);
+    EXPECT_EQ(parsed[0].name, "loop \"sum\"");
+    EXPECT_EQ(parsed[0].ops, 1000);
+    EXPECT_EQ(parsed[1].name, "external");
+    EXPECT_DOUBLE_EQ(parsed[1].ns_per_op, 50.0);
+    for (int e = 0; e < perf_event_count; ++e) {
+        EXPECT_FALSE(parsed[1].available[e]);
+        EXPECT_EQ(parsed[0].available[e], harness.results()[0].available[e]);
+    }
+}
+
+TEST(WorkStealingTests, DequeOwnerAndThief) {
+    StealingDeque deque(4);
+    StealableJob jobs[5];
+    EXPECT_THROW(StealingDeque(6), std::invalid_argument);
+    EXPECT_EQ(deque.pop(), nullptr);
+    EXPECT_EQ(deque.steal(), nullptr);
+    for (int i = 0; i < 4; ++i) EXPECT_TRUE(deque.push(&jobs[i]));
+    EXPECT_FALSE(deque.push(&jobs[4]));
+    EXPECT_EQ(deque.steal(), &jobs[0]);
+    EXPECT_EQ(deque.pop(), &jobs[3]);
+    EXPECT_TRUE(deque.push(&jobs[4]));
+    EXPECT_EQ(deque.size(), 3);
+    EXPECT_EQ(deque.steal(), &jobs[1]);
+    EXPECT_EQ(deque.pop(), &jobs[4]);
+    EXPECT_EQ(deque.pop(), &jobs[2]);
+    EXPECT_EQ(deque.pop(), nullptr);
+}
+
+static long parallel_sum(WorkStealingPool &pool, const std::vector<int> &data, size_t begin, size_t end) {
+    if (end - begin <= 64) {
+        long sum = 0;
+        for (size_t i = begin; i < end; ++i) sum += data[i];
+        return sum;
+    }
+    size_t middle = begin + (end - begin) / 2;
+    long left = 0;
+    TaskGroup group;
+    pool.spawn(group, [&] { left = parallel_sum(pool, data, begin, middle); });
+    long right = parallel_sum(pool, data, middle, end);
+    pool.wait(group);
+    return left + right;
+}
+
+TEST(WorkStealingTests, RecursiveSumWithOverflow) {
+    std::vector<int> data(100000);
+    for (size_t i = 0; i < data.size(); ++i) data[i] = static_cast<int>(i % 1000);
+    long expected = 0;
+    for (int v : data) expected += v;
+
+    WorkStealingPool pool(4, 2);
+    EXPECT_EQ(pool.size(), 4);
+    TaskGroup group;
+    long result = 0;
+    pool.spawn(group, [&] { result = parallel_sum(pool, data, 0, data.size()); });
+    pool.wait(group);
+    EXPECT_EQ(result, expected);
+    EXPECT_EQ(group.unfinished(), 0);
+}
+
+TEST(WorkStealingTests, WaitRethrowsJobException) {
+    WorkStealingPool pool(2);
+    TaskGroup group;
+    std::atomic<int> ran(0);
+    for (int i = 0; i < 100; ++i) {
+        pool.spawn(group, [&ran, i] {
+            ++ran;
+            if (i == 37) throw std::runtime_error("job failed");
+        });
+    }
+    EXPECT_THROW(pool.wait(group), std::runtime_error);
+    EXPECT_EQ(ran.load(), 100);
+    pool.spawn(group, [&ran] { ++ran; });
+    pool.wait(group);
+    EXPECT_EQ(ran.load(), 101);
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
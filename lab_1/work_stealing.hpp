@@ -0,0 +1,265 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Counts the unfinished jobs spawned into it; WorkStealingPool::wait
+// joins on it and rethrows the first exception a job threw.
+class TaskGroup {
+private:
+    friend class WorkStealingPool;
+
+    std::atomic<long> pending;
+    std::mutex error_lock;
+    std::exception_ptr error;
+
+public:
+    TaskGroup() : pending(0) {}
+
+    TaskGroup(const TaskGroup &) = delete;
+    TaskGroup &operator=(const TaskGroup &) = delete;
+
+    long unfinished() const { return pending.load(std::memory_order_acquire); }
+};
+
+struct StealableJob {
+    std::function<void()> body;
+    TaskGroup *group;
+};
+
+// Bounded Chase-Lev deque over a power-of-two ring with monotonically
+// growing indices, like CircularBuffer's head/count addressing but with
+// the owner working at the bottom and thieves taking from the top.
+// push and pop are owner-only; steal may be called from any thread.
+class StealingDeque {
+private:
+    std::unique_ptr<std::atomic<StealableJob *>[]> slots;
+    long mask;
+    alignas(64) std::atomic<long> top;
+    alignas(64) std::atomic<long> bottom;
+
+public:
+    explicit StealingDeque(int capacity) : top(0), bottom(0) {
+        if (capacity < 1 || (capacity & (capacity - 1)) != 0) {
+            throw std::invalid_argument("Deque capacity must be a power of two");
+        }
+        slots.reset(new std::atomic<StealableJob *>[capacity]);
+        mask = capacity - 1;
+    }
+
+    StealingDeque(const StealingDeque &) = delete;
+    StealingDeque &operator=(const StealingDeque &) = delete;
+
+    // Returns false when the ring is full.
+    bool push(StealableJob *job) {
+        long b = bottom.load(std::memory_order_relaxed);
+        long t = top.load(std::memory_order_acquire);
+        if (b - t > mask) return false;
+        slots[b & mask].store(job, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    StealableJob *pop() {
+        long b = bottom.load(std::memory_order_relaxed) - 1;
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        long t = top.load(std::memory_order_relaxed);
+        if (t > b) {
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        StealableJob *job = slots[b & mask].load(std::memory_order_relaxed);
+        if (t == b) {
+            // Last element: race the thieves for it.
+            if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                job = nullptr;
+            }
+            bottom.store(b + 1, std::memory_order_relaxed);
+        }
+        return job;
+    }
+
+    StealableJob *steal() {
+        long t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        long b = bottom.load(std::memory_order_acquire);
+        if (t >= b) return nullptr;
+        StealableJob *job = slots[t & mask].load(std::memory_order_relaxed);
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return nullptr;
+        }
+        return job;
+    }
+
+    long size() const {
+        long n = bottom.load(std::memory_order_relaxed) - top.load(std::memory_order_relaxed);
+        return n < 0 ? 0 : n;
+    }
+
+    int capacity() const { return static_cast<int>(mask + 1); }
+};
+
+// Fixed pool of workers, each owning a StealingDeque. Jobs spawned on a
+// worker go to its own deque (a global queue takes the overflow and jobs
+// spawned from outside the pool); idle workers steal from the others.
+// wait() helps run jobs instead of blocking, so recursive fork/join does
+// not deadlock.
+class WorkStealingPool {
+private:
+    struct Worker {
+        StealingDeque deque;
+        unsigned victim_seed;
+
+        Worker(int capacity, unsigned seed) : deque(capacity), victim_seed(seed) {}
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+    std::mutex global_lock;
+    std::deque<StealableJob *> global;
+    std::atomic<long> global_size;
+    std::mutex idle_lock;
+    std::condition_variable idle_cv;
+    std::atomic<int> sleepers;
+    std::atomic<long> epoch;
+    std::atomic<bool> stopping;
+
+    static inline thread_local WorkStealingPool *current_pool = nullptr;
+    static inline thread_local int current_worker = -1;
+
+    int self() const { return current_pool == this ? current_worker : -1; }
+
+    void enqueue(StealableJob *job) {
+        int me = self();
+        if (me < 0 || !workers[me]->deque.push(job)) {
+            std::lock_guard<std::mutex> guard(global_lock);
+            global.push_back(job);
+            global_size.fetch_add(1, std::memory_order_relaxed);
+        }
+        epoch.fetch_add(1, std::memory_order_seq_cst);
+        if (sleepers.load(std::memory_order_seq_cst) > 0) {
+            std::lock_guard<std::mutex> guard(idle_lock);
+            idle_cv.notify_one();
+        }
+    }
+
+    StealableJob *take_global() {
+        if (global_size.load(std::memory_order_relaxed) == 0) return nullptr;
+        std::lock_guard<std::mutex> guard(global_lock);
+        if (global.empty()) return nullptr;
+        StealableJob *job = global.front();
+        global.pop_front();
+        global_size.fetch_sub(1, std::memory_order_relaxed);
+        return job;
+    }
+
+    StealableJob *find_job(int me) {
+        if (me >= 0) {
+            if (StealableJob *job = workers[me]->deque.pop()) return job;
+        }
+        if (StealableJob *job = take_global()) return job;
+        int n = static_cast<int>(workers.size());
+        unsigned seed = me >= 0 ? workers[me]->victim_seed : 0;
+        seed = seed * 1103515245u + 12345u;
+        if (me >= 0) workers[me]->victim_seed = seed;
+        int start = static_cast<int>((seed >> 16) % n);
+        for (int i = 0; i < n; ++i) {
+            int victim = (start + i) % n;
+            if (victim == me) continue;
+            if (StealableJob *job = workers[victim]->deque.steal()) return job;
+        }
+        return nullptr;
+    }
+
+    static void run(StealableJob *job) {
+        TaskGroup *group = job->group;
+        try {
+            job->body();
+        } catch (...) {
+            std::lock_guard<std::mutex> guard(group->error_lock);
+            if (!group->error) group->error = std::current_exception();
+        }
+        delete job;
+        group->pending.fetch_sub(1, std::memory_order_acq_rel);
+    }
+
+    void work(int me) {
+        current_pool = this;
+        current_worker = me;
+        while (true) {
+            long seen = epoch.load(std::memory_order_seq_cst);
+            if (StealableJob *job = find_job(me)) {
+                run(job);
+                continue;
+            }
+            if (stopping.load(std::memory_order_acquire)) return;
+            std::unique_lock<std::mutex> guard(idle_lock);
+            sleepers.fetch_add(1, std::memory_order_seq_cst);
+            idle_cv.wait(guard, [&] {
+                return stopping.load(std::memory_order_acquire) || epoch.load(std::memory_order_seq_cst) != seen;
+            });
+            sleepers.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+
+public:
+    explicit WorkStealingPool(int thread_count = static_cast<int>(std::thread::hardware_concurrency()),
+                              int deque_capacity = 1024)
+        : global_size(0), sleepers(0), epoch(0), stopping(false) {
+        if (thread_count < 1) thread_count = 1;
+        for (int i = 0; i < thread_count; ++i) {
+            workers.emplace_back(new Worker(deque_capacity, 2654435761u * (i + 1)));
+        }
+        for (int i = 0; i < thread_count; ++i) {
+            threads.emplace_back([this, i] { work(i); });
+        }
+    }
+
+    // Outstanding jobs are finished before the workers exit.
+    ~WorkStealingPool() {
+        {
+            std::lock_guard<std::mutex> guard(idle_lock);
+            stopping.store(true, std::memory_order_release);
+        }
+        idle_cv.notify_all();
+        for (std::thread &thread : threads) thread.join();
+    }
+
+    WorkStealingPool(const WorkStealingPool &) = delete;
+    WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+    template <class F>
+    void spawn(TaskGroup &group, F &&body) {
+        group.pending.fetch_add(1, std::memory_order_relaxed);
+        enqueue(new StealableJob{std::function<void()>(std::forward<F>(body)), &group});
+    }
+
+    // Runs jobs until every job of the group has finished, then rethrows
+    // the first exception one of them threw.
+    void wait(TaskGroup &group) {
+        int me = self();
+        while (group.pending.load(std::memory_order_acquire) > 0) {
+            if (StealableJob *job = find_job(me)) run(job);
+            else std::this_thread::yield();
+        }
+        std::exception_ptr error;
+        {
+            std::lock_guard<std::mutex> guard(group.error_lock);
+            error.swap(group.error);
+        }
+        if (error) std::rethrow_exception(error);
+    }
+
+    int size() const { return static_cast<int>(threads.size()); }
+};
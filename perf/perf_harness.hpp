@@ -0,0 +1,341 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Benchmark regions measured with wall-clock time and, where the kernel
+// allows it, hardware counters from perf_event_open. Counters that cannot
+// be opened (no PMU in a VM, perf_event_paranoid, seccomp in a container)
+// are reported as unavailable instead of failing the run.
+//
+// Results can be saved as a JSON baseline and compared on a later run:
+//     bench --save base.json
+//     bench --compare base.json
+
+enum PerfEvent {
+    perf_cycles,
+    perf_instructions,
+    perf_l1d_misses,
+    perf_llc_misses,
+    perf_branch_misses,
+    perf_dtlb_misses,
+    perf_event_count
+};
+
+inline const char *perf_event_name(int event) {
+    static const char *names[perf_event_count] = {
+        "cycles", "instructions", "l1d_misses", "llc_misses", "branch_misses", "dtlb_misses"};
+    return names[event];
+}
+
+struct PerfSample {
+    std::string name;
+    long ops = 0;
+    double ns_per_op = 0;
+    double per_op[perf_event_count] = {};
+    bool available[perf_event_count] = {};
+};
+
+// One counter per event, opened independently so a missing event does not
+// take the others down. inherit makes threads started inside a region
+// count too. Multiplexed counters are scaled by enabled/running time.
+class PerfCounters {
+private:
+    int fds[perf_event_count];
+
+#ifdef __linux__
+    static int open_event(int event) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.disabled = 1;
+        attr.inherit = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        const unsigned long long read_miss =
+            (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        switch (event) {
+        case perf_cycles:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CPU_CYCLES;
+            break;
+        case perf_instructions:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+            break;
+        case perf_l1d_misses:
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = PERF_COUNT_HW_CACHE_L1D | read_miss;
+            break;
+        case perf_llc_misses:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CACHE_MISSES;
+            break;
+        case perf_branch_misses:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+            break;
+        default:
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = PERF_COUNT_HW_CACHE_DTLB | read_miss;
+            break;
+        }
+        return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+#endif
+
+public:
+    PerfCounters() {
+        for (int i = 0; i < perf_event_count; ++i) {
+#ifdef __linux__
+            fds[i] = open_event(i);
+#else
+            fds[i] = -1;
+#endif
+        }
+    }
+
+    ~PerfCounters() {
+#ifdef __linux__
+        for (int fd : fds) {
+            if (fd >= 0) close(fd);
+        }
+#endif
+    }
+
+    PerfCounters(const PerfCounters &) = delete;
+    PerfCounters &operator=(const PerfCounters &) = delete;
+
+    bool available(int event) const { return fds[event] >= 0; }
+
+    bool any_available() const {
+        for (int fd : fds) {
+            if (fd >= 0) return true;
+        }
+        return false;
+    }
+
+    void start() {
+#ifdef __linux__
+        for (int fd : fds) {
+            if (fd < 0) continue;
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    // Counts since start(), -1 for events that are unavailable or never ran.
+    void stop(double values[perf_event_count]) {
+        for (int i = 0; i < perf_event_count; ++i) {
+            values[i] = -1;
+#ifdef __linux__
+            if (fds[i] < 0) continue;
+            ioctl(fds[i], PERF_EVENT_IOC_DISABLE, 0);
+            unsigned long long data[3];
+            if (read(fds[i], data, sizeof(data)) != sizeof(data) || data[2] == 0) continue;
+            values[i] = static_cast<double>(data[0]) * data[1] / data[2];
+#endif
+        }
+    }
+};
+
+class PerfHarness {
+private:
+    typedef std::chrono::steady_clock clock;
+
+    PerfCounters counters;
+    clock::time_point begin;
+    std::vector<PerfSample> samples;
+    std::map<std::string, PerfSample> baseline;
+    std::string save_path;
+
+    static void skip_space(const std::string &text, size_t &pos) {
+        while (pos < text.size() && std::strchr(" \t\r\n,:", text[pos])) ++pos;
+    }
+
+    static std::string parse_string(const std::string &text, size_t &pos) {
+        std::string out;
+        ++pos;
+        while (pos < text.size() && text[pos] != '"') {
+            if (text[pos] == '\\' && pos + 1 < text.size()) ++pos;
+            out += text[pos++];
+        }
+        ++pos;
+        return out;
+    }
+
+    static std::string json_escape(const std::string &text) {
+        std::string out;
+        for (char c : text) {
+            if (c == '"' || c == '\\') out += '\\';
+            out += c;
+        }
+        return out;
+    }
+
+    void print(const PerfSample &sample) const {
+        std::printf("%-40s %10.2f ns/op", sample.name.c_str(), sample.ns_per_op);
+        if (sample.available[perf_cycles] && sample.available[perf_instructions]) {
+            std::printf(" %9.1f cyc %6.2f IPC", sample.per_op[perf_cycles],
+                        sample.per_op[perf_cycles] > 0 ? sample.per_op[perf_instructions] / sample.per_op[perf_cycles] : 0.0);
+        }
+        for (int i = perf_l1d_misses; i < perf_event_count; ++i) {
+            if (sample.available[i]) std::printf(" %8.4f %s", sample.per_op[i], perf_event_name(i));
+        }
+        std::map<std::string, PerfSample>::const_iterator old = baseline.find(sample.name);
+        if (old != baseline.end() && old->second.ns_per_op > 0) {
+            std::printf("  [%+.1f%% vs baseline]", (sample.ns_per_op / old->second.ns_per_op - 1) * 100);
+        }
+        std::printf("\n");
+    }
+
+public:
+    PerfHarness() {}
+
+    // Understands --save <file> and --compare <file>; other arguments are
+    // left to the caller.
+    PerfHarness(int argc, char **argv) {
+        for (int i = 1; i + 1 < argc; ++i) {
+            if (std::strcmp(argv[i], "--save") == 0) save_path = argv[++i];
+            else if (std::strcmp(argv[i], "--compare") == 0) load_baseline(argv[++i]);
+        }
+        if (!counters.any_available()) std::printf("perf counters unavailable, reporting wall-clock time only\n");
+    }
+
+    ~PerfHarness() {
+        if (!save_path.empty() && !save_json(save_path)) {
+            std::fprintf(stderr, "cannot write %s\n", save_path.c_str());
+        }
+    }
+
+    PerfHarness(const PerfHarness &) = delete;
+    PerfHarness &operator=(const PerfHarness &) = delete;
+
+    void start() {
+        counters.start();
+        begin = clock::now();
+    }
+
+    // Ends the region opened by start() and reports it per operation.
+    const PerfSample &stop(const std::string &name, long ops) {
+        double ns = std::chrono::duration<double, std::nano>(clock::now() - begin).count();
+        double values[perf_event_count];
+        counters.stop(values);
+        PerfSample sample;
+        sample.name = name;
+        sample.ops = ops;
+        sample.ns_per_op = ns / ops;
+        for (int i = 0; i < perf_event_count; ++i) {
+            sample.available[i] = values[i] >= 0;
+            sample.per_op[i] = sample.available[i] ? values[i] / ops : 0;
+        }
+        samples.push_back(sample);
+        print(samples.back());
+        return samples.back();
+    }
+
+    // Result timed by the caller, without counters.
+    const PerfSample &record(const std::string &name, double ns, long ops) {
+        PerfSample sample;
+        sample.name = name;
+        sample.ops = ops;
+        sample.ns_per_op = ns / ops;
+        samples.push_back(sample);
+        print(samples.back());
+        return samples.back();
+    }
+
+    template <class F>
+    const PerfSample &measure(const std::string &name, long ops, F body) {
+        start();
+        body();
+        return stop(name, ops);
+    }
+
+    const std::vector<PerfSample> &results() const { return samples; }
+
+    std::string to_json() const {
+        std::ostringstream out;
+        out << "{\n  \"benchmarks\": [\n";
+        for (size_t i = 0; i < samples.size(); ++i) {
+            const PerfSample &sample = samples[i];
+            out << "    {\"name\": \"" << json_escape(sample.name) << "\", \"ops\": " << sample.ops
+                << ", \"ns_per_op\": " << sample.ns_per_op;
+            for (int e = 0; e < perf_event_count; ++e) {
+                out << ", \"" << perf_event_name(e) << "\": ";
+                if (sample.available[e]) out << sample.per_op[e];
+                else out << "null";
+            }
+            out << "}" << (i + 1 < samples.size() ? "," : "") << "\n";
+        }
+        out << "  ]\n}\n";
+        return out.str();
+    }
+
+    bool save_json(const std::string &path) const {
+        std::ofstream file(path);
+        file << to_json();
+        return static_cast<bool>(file);
+    }
+
+    // Reads the flat objects written by to_json(); unknown keys are ignored.
+    static std::vector<PerfSample> parse_json(const std::string &text) {
+        std::vector<PerfSample> out;
+        size_t pos = text.find('[');
+        while (pos != std::string::npos && pos < text.size()) {
+            pos = text.find('{', pos);
+            if (pos == std::string::npos) break;
+            ++pos;
+            PerfSample sample;
+            while (true) {
+                skip_space(text, pos);
+                if (pos >= text.size() || text[pos] == '}') break;
+                std::string key = parse_string(text, pos);
+                skip_space(text, pos);
+                if (pos < text.size() && text[pos] == '"') {
+                    std::string value = parse_string(text, pos);
+                    if (key == "name") sample.name = value;
+                    continue;
+                }
+                size_t end = text.find_first_of(",}", pos);
+                std::string value = text.substr(pos, end - pos);
+                pos = end;
+                if (key == "ops") sample.ops = std::atol(value.c_str());
+                else if (key == "ns_per_op") sample.ns_per_op = std::atof(value.c_str());
+                for (int e = 0; e < perf_event_count; ++e) {
+                    if (key != perf_event_name(e) || value.compare(0, 4, "null") == 0) continue;
+                    sample.per_op[e] = std::atof(value.c_str());
+                    sample.available[e] = true;
+                }
+            }
+            ++pos;
+            if (!sample.name.empty()) out.push_back(sample);
+        }
+        return out;
+    }
+
+    bool load_baseline(const std::string &path) {
+        std::ifstream file(path);
+        if (!file) return false;
+        std::stringstream text;
+        text << file.rdbuf();
+        for (const PerfSample &sample : parse_json(text.str())) baseline[sample.name] = sample;
+        return true;
+    }
+};